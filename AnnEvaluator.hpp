@@ -0,0 +1,265 @@
+#ifndef __ANN_EVALUATOR_HPP__
+#define __ANN_EVALUATOR_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AnnResultReader.hpp"
+#include "ParallelUtils.hpp"
+#include "VecsReader.h"
+
+// evaluation of ANN search results against the ground truth, i.e., what the
+// gdist and ratio columns of AnnResultWriter are about
+namespace AnnEval {
+// recall@1, recall@10 and recall@100
+constexpr unsigned RecallAt[] = {1, 10, 100};
+constexpr size_t NumRecallAt = sizeof(RecallAt) / sizeof(RecallAt[0]);
+} // namespace AnnEval
+
+// ids and optionally distances of the K nearest neighbors of every query,
+// e.g., the .ivecs files of the SIFT/GIST/BIGANN benchmarks
+class GroundTruth {
+public:
+  GroundTruth() : _k(0) {}
+
+  // <idsFile> is an .ivecs file of neighbor ids, <distFile> an optional
+  // .fvecs or .ivecs file of the matching distances
+  explicit GroundTruth(const std::string &idsFile,
+                       const std::string &distFile = "") {
+    _ids = readVecs<int>(idsFile, &_k);
+    if (!distFile.empty()) {
+      unsigned dim;
+      _dists = readVecs<float>(distFile, &dim);
+      if (dim != _k || _dists.size() != _ids.size())
+        throw std::runtime_error("GroundTruth::GroundTruth(): " + distFile +
+                                 " does not match " + idsFile);
+    }
+  }
+
+  // <ids> and <dists> hold k values per query
+  GroundTruth(std::vector<int> ids, unsigned k,
+              std::vector<float> dists = std::vector<float>())
+      : _ids(std::move(ids)), _dists(std::move(dists)), _k(k) {
+    if (k == 0 || _ids.size() % k != 0 ||
+        (!_dists.empty() && _dists.size() != _ids.size()))
+      throw std::runtime_error("GroundTruth::GroundTruth(): bad sizes");
+  }
+
+  size_t numQueries() const { return _k == 0 ? 0 : _ids.size() / _k; }
+  // neighbors per query
+  unsigned k() const { return _k; }
+  bool hasDistances() const { return !_dists.empty(); }
+  const int *ids(size_t q) const { return &_ids[q * _k]; }
+  const float *distances(size_t q) const { return &_dists[q * _k]; }
+
+private:
+  std::vector<int> _ids;
+  std::vector<float> _dists;
+  unsigned _k;
+};
+
+// results of one query; NaN if not computable, e.g., recall@100 of 10
+// results or the ratio without distances
+struct QueryEval {
+  double recall[AnnEval::NumRecallAt];
+  double ratio;
+};
+
+struct Evaluation {
+  size_t numQueries = 0;
+  unsigned k = 0; // results per query
+  // means over the queries, NaN if not computable
+  double recall[AnnEval::NumRecallAt] = {
+      std::numeric_limits<double>::quiet_NaN(),
+      std::numeric_limits<double>::quiet_NaN(),
+      std::numeric_limits<double>::quiet_NaN()};
+  double ratio = std::numeric_limits<double>::quiet_NaN();
+  std::vector<QueryEval> perQuery;
+
+  // one line, e.g., "queries=10000 k=100 recall@1=0.99 ... ratio=1.0003"
+  std::string summary() const {
+    char line[256];
+    int len = snprintf(line, sizeof(line), "queries=%zu k=%u", numQueries, k);
+    for (size_t i = 0; i < AnnEval::NumRecallAt; ++i)
+      if (!std::isnan(recall[i]))
+        len += snprintf(line + len, sizeof(line) - len, " recall@%u=%.6f",
+                        AnnEval::RecallAt[i], recall[i]);
+    if (!std::isnan(ratio))
+      snprintf(line + len, sizeof(line) - len, " ratio=%.6f", ratio);
+    return line;
+  }
+};
+
+// k results per query: the ids of the i-th query are ids[i * k, (i + 1) * k)
+// sorted by distance, with -1 for missing ones, and <dists> is nullptr or
+// holds the matching distances. recall@r is the fraction of the true r
+// nearest neighbors among the first r results, each counted once however
+// often it is listed; the ratio of a query is the mean of rdist / gdist over
+// its results, i.e., the j-th result distance over the j-th true one, with
+// the distances as given, e.g., squared. The queries are evaluated by
+// <numThreads> threads (0 means all cores).
+inline Evaluation evaluate(const GroundTruth &gt, const int *ids,
+                           const float *dists, size_t numQueries, unsigned k,
+                           unsigned numThreads = 0) {
+  if (numQueries > gt.numQueries())
+    throw std::runtime_error("evaluate(): " + std::to_string(numQueries) +
+                             " queries but ground truth of " +
+                             std::to_string(gt.numQueries()));
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const unsigned gk = gt.k();
+  const bool withRatio = dists != nullptr && gt.hasDistances();
+
+  Evaluation ev;
+  ev.numQueries = numQueries;
+  ev.k = k;
+  ev.perQuery.resize(numQueries);
+  ParallelUtils::parallelFor(numQueries, numThreads, [&](size_t begin,
+                                                         size_t end,
+                                                         unsigned) {
+    // true neighbors by id, to find the rank of a result in the ground truth
+    std::vector<std::pair<int, unsigned>> byId(gk);
+    // ranks already found, so a repeated result is not counted again
+    std::vector<char> seen(gk);
+    for (size_t q = begin; q < end; ++q) {
+      const int *truth = gt.ids(q);
+      const int *res = ids + q * k;
+      for (unsigned j = 0; j < gk; ++j)
+        byId[j] = {truth[j], j};
+      std::sort(byId.begin(), byId.end());
+      std::fill(seen.begin(), seen.end(), 0);
+
+      size_t hits[AnnEval::NumRecallAt] = {0};
+      for (unsigned j = 0; j < k; ++j) {
+        if (res[j] < 0)
+          continue;
+        auto it = std::lower_bound(byId.begin(), byId.end(),
+                                   std::make_pair(res[j], 0u));
+        if (it == byId.end() || it->first != res[j] || seen[it->second])
+          continue;
+        seen[it->second] = 1;
+        for (size_t i = 0; i < AnnEval::NumRecallAt; ++i)
+          if (j < AnnEval::RecallAt[i] && it->second < AnnEval::RecallAt[i])
+            ++hits[i];
+      }
+      QueryEval &qe = ev.perQuery[q];
+      for (size_t i = 0; i < AnnEval::NumRecallAt; ++i) {
+        unsigned r = AnnEval::RecallAt[i];
+        qe.recall[i] = (r <= k && r <= gk) ? double(hits[i]) / r : nan;
+      }
+
+      qe.ratio = nan;
+      if (withRatio) {
+        const float *rd = dists + q * k, *gd = gt.distances(q);
+        double sum = 0;
+        unsigned n = 0;
+        for (unsigned j = 0; j < k && j < gk; ++j) {
+          if (res[j] < 0)
+            continue;
+          if (gd[j] > 0)
+            sum += double(rd[j]) / gd[j];
+          else if (rd[j] == 0)
+            sum += 1; // exact duplicate of the query
+          else
+            continue;
+          ++n;
+        }
+        if (n > 0)
+          qe.ratio = sum / n;
+      }
+    }
+  });
+
+  // means over the queries where a value is defined
+  for (size_t i = 0; i <= AnnEval::NumRecallAt; ++i) {
+    double sum = 0;
+    size_t n = 0;
+    for (const auto &qe : ev.perQuery) {
+      double v = i < AnnEval::NumRecallAt ? qe.recall[i] : qe.ratio;
+      if (!std::isnan(v)) {
+        sum += v;
+        ++n;
+      }
+    }
+    double mean = n == 0 ? nan : sum / n;
+    if (i < AnnEval::NumRecallAt)
+      ev.recall[i] = mean;
+    else
+      ev.ratio = mean;
+  }
+  return ev;
+}
+
+inline Evaluation evaluate(const GroundTruth &gt, const std::vector<int> &ids,
+                           const std::vector<float> &dists, unsigned k,
+                           unsigned numThreads = 0) {
+  if (k == 0 || ids.size() % k != 0 ||
+      (!dists.empty() && dists.size() != ids.size()))
+    throw std::runtime_error("evaluate(): bad result sizes");
+  return evaluate(gt, ids.data(), dists.empty() ? nullptr : dists.data(),
+                  ids.size() / k, k, numThreads);
+}
+
+// search results as arrays of k per query, e.g., loaded from the output of
+// AnnResultWriter
+struct AnnResultSet {
+  std::vector<int> ids;     // -1 for missing results
+  std::vector<float> dists; // empty if there is no rdist column
+  size_t numQueries = 0;
+  unsigned k = 0;
+};
+
+// read the #qid, #kid, #rid and, if present, rdist columns of a file written
+// by AnnResultWriter with AnnResultReader (other columns are parsed but not
+// used). Query ids are 0-based and #kid is the 0-based rank of the result,
+// or 1-based if the smallest #kid in the file is 1.
+inline AnnResultSet loadAnnResults(const std::string &filename,
+                                   unsigned numThreads = 0) {
+  AnnResultReader reader(filename, "", numThreads);
+  if (!reader.hasColumn("#qid") || !reader.hasColumn("#kid") ||
+      !reader.hasColumn("#rid"))
+    throw std::runtime_error("loadAnnResults(): " + filename +
+                             " has no #qid, #kid and #rid columns");
+  auto qids = reader.column<int>("#qid");
+  auto kids = reader.column<int>("#kid");
+  auto rids = reader.column<int>("#rid");
+  bool withDists = reader.hasColumn("rdist");
+  auto rdists =
+      withDists ? reader.column<float>("rdist") : std::vector<float>();
+
+  AnnResultSet rs;
+  if (qids.empty())
+    return rs;
+  int minQid = *std::min_element(qids.begin(), qids.end());
+  int minKid = *std::min_element(kids.begin(), kids.end());
+  if (minQid < 0 || minKid < 0)
+    throw std::runtime_error("loadAnnResults(): negative #qid or #kid in " +
+                             filename);
+  int base = minKid == 1 ? 1 : 0;
+  rs.numQueries = *std::max_element(qids.begin(), qids.end()) + 1;
+  rs.k = *std::max_element(kids.begin(), kids.end()) - base + 1;
+  rs.ids.assign(rs.numQueries * rs.k, -1);
+  if (withDists)
+    rs.dists.assign(rs.numQueries * rs.k, 0);
+  for (size_t r = 0; r < qids.size(); ++r) {
+    size_t i = size_t(qids[r]) * rs.k + (kids[r] - base);
+    rs.ids[i] = rids[r];
+    if (withDists)
+      rs.dists[i] = rdists[r];
+  }
+  return rs;
+}
+
+inline Evaluation evaluate(const GroundTruth &gt, const AnnResultSet &rs,
+                           unsigned numThreads = 0) {
+  return evaluate(gt, rs.ids.data(),
+                  rs.dists.empty() ? nullptr : rs.dists.data(), rs.numQueries,
+                  rs.k, numThreads);
+}
+
+#endif
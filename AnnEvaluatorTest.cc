@@ -0,0 +1,134 @@
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "AnnEvaluator.hpp"
+#include "AnnResultWriter.hpp"
+#include "Exception.h"
+#include "Timer.hpp"
+#include "TypedAnnResultWriter.hpp"
+
+using namespace npp;
+
+// write <n> rows of <dim> values
+template <typename T>
+void writeVecs(const char *filename, const std::vector<T> &data, int dim) {
+  FILE *fp = fopen(filename, "wb");
+  NPP_ASSERT_NOT_NULL(fp);
+  for (size_t i = 0; i < data.size(); i += dim) {
+    fwrite(&dim, sizeof(int), 1, fp);
+    fwrite(&data[i], sizeof(T), dim, fp);
+  }
+  fclose(fp);
+}
+
+bool near(double a, double b) { return std::abs(a - b) < 1e-9; }
+
+int main() {
+  try {
+    // 10k queries with 100 true neighbors each at distances 100 + j
+    const size_t nq = 10000;
+    const unsigned k = 100;
+    std::mt19937 gen(2020);
+    std::vector<int> gtIds(nq * k);
+    std::vector<float> gtDists(nq * k);
+    for (size_t q = 0; q < nq; ++q)
+      for (unsigned j = 0; j < k; ++j) {
+        gtIds[q * k + j] = static_cast<int>(q * 1000 + j * 7);
+        gtDists[q * k + j] = 100.0f + j;
+      }
+    writeVecs("ann-evaluator-test.ivecs", gtIds, k);
+    writeVecs("ann-evaluator-test.fvecs", gtDists, k);
+    GroundTruth gt("ann-evaluator-test.ivecs", "ann-evaluator-test.fvecs");
+    NPP_ASSERT(gt.numQueries() == nq && gt.k() == k && gt.hasDistances());
+
+    // exact results
+    auto ev = evaluate(gt, gtIds, gtDists, k);
+    for (size_t i = 0; i < AnnEval::NumRecallAt; ++i)
+      NPP_ASSERT(ev.recall[i] == 1.0);
+    NPP_ASSERT(ev.ratio == 1.0 && ev.perQuery.size() == nq);
+
+    // query q misses its (q % 3)-th neighbor, found a farther point at
+    // distance 300 instead, listed last
+    std::vector<int> ids(nq * k);
+    std::vector<float> dists(nq * k);
+    double recall1 = 0, recall10 = 0, ratio = 0;
+    for (size_t q = 0; q < nq; ++q) {
+      unsigned miss = q % 3;
+      unsigned j = 0;
+      double sum = 0;
+      for (unsigned t = 0; t < k; ++t)
+        if (t != miss) {
+          ids[q * k + j] = gtIds[q * k + t];
+          dists[q * k + j] = gtDists[q * k + t];
+          sum += double(dists[q * k + j]) / gtDists[q * k + j];
+          ++j;
+        }
+      ids[q * k + j] = 999999999; // not a neighbor
+      dists[q * k + j] = 300;
+      sum += 300.0 / gtDists[q * k + j];
+      recall1 += miss == 0 ? 0 : 1;
+      recall10 += 0.9;
+      ratio += sum / k;
+    }
+    HighResolutionTimer timer;
+    timer.restart();
+    ev = evaluate(gt, ids, dists, k);
+    auto e = timer.elapsed();
+    NPP_ASSERT(near(ev.recall[0], recall1 / nq));
+    NPP_ASSERT(near(ev.recall[1], recall10 / nq));
+    NPP_ASSERT(near(ev.recall[2], 0.99));
+    NPP_ASSERT(near(ev.ratio, ratio / nq));
+    NPP_ASSERT(ev.perQuery[0].recall[0] == 0 && ev.perQuery[1].recall[0] == 1);
+    auto single = evaluate(gt, ids, dists, k, 1);
+    NPP_ASSERT(single.summary() == ev.summary());
+    std::cout << ev.summary() << "\n"
+              << nq << " x " << k << " results in " << e / 1000 << " ms"
+              << std::endl;
+
+    // 10 results per query from the writer's output, the first 100 queries
+    // only; the rdist column gives the ratio, which is NaN once the
+    // distances are dropped
+    {
+      TypedAnnResultWriter<int, int, int, int, int, double, double> writer(
+          "ann-evaluator-test.txt", true);
+      writer.writeHeader(AnnResults::_DEFAULT_HEADER_I_);
+      for (int q = 0; q < 100; ++q)
+        for (int j = 0; j < 10; ++j)
+          writer.writeRow(q, j, ids[q * k + j], int(dists[q * k + j]), 0, 0.0,
+                          1.0);
+    }
+    auto rs = loadAnnResults("ann-evaluator-test.txt");
+    NPP_ASSERT(rs.numQueries == 100 && rs.k == 10 && rs.dists.size() == 1000);
+    ev = evaluate(gt, rs);
+    NPP_ASSERT(std::isnan(ev.recall[2]) && !std::isnan(ev.ratio));
+    NPP_ASSERT(near(ev.recall[1], 0.9) && near(ev.recall[0], 66.0 / 100));
+    ev = evaluate(gt, rs.ids, {}, rs.k);
+    NPP_ASSERT(std::isnan(ev.ratio));
+    std::cout << ev.summary() << std::endl;
+
+    // a result listed twice is one hit, so recall stays at most 1
+    std::vector<int> dup(gtIds.begin(), gtIds.begin() + 10 * k);
+    for (size_t q = 0; q < 10; ++q)
+      dup[q * k + 1] = dup[q * k];
+    ev = evaluate(gt, dup, {}, k);
+    NPP_ASSERT(ev.recall[0] == 1.0 && near(ev.recall[1], 0.9) &&
+               near(ev.recall[2], 0.99));
+
+    bool thrown = false;
+    try {
+      evaluate(gt, std::vector<int>((nq + 1) * 10), {}, 10);
+    } catch (const std::runtime_error &) {
+      thrown = true; // more queries than ground truth
+    }
+    NPP_ASSERT(thrown);
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  remove("ann-evaluator-test.ivecs");
+  remove("ann-evaluator-test.fvecs");
+  remove("ann-evaluator-test.txt");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+#ifndef __ANNRESULT_BIN_HPP__
+#define __ANNRESULT_BIN_HPP__
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Exception.h"
+
+// Binary columnar ANN results: a schema header (one name and type per
+// column, e.g., from AnnResults::_DEFAULT_HEADER_E_/_DEFAULT_FMT_E_) followed
+// by blocks of rows. Every block is a uint32_t row count and then one typed
+// array per column, so writing a row is a few memcpy's and whole blocks go to
+// the file at once. Column types are the AnnResultWriter format characters:
+// 'i' int32_t, 'f'/'d' double and 'c' char.
+namespace AnnResultBin {
+
+constexpr char Magic[8] = {'A', 'N', 'N', 'R', 'B', 'I', 'N', '\0'};
+constexpr uint32_t Version = 1;
+constexpr size_t DefaultBlockRows = 1u << 16;
+
+inline size_t typeSize(char type) {
+  switch (type) {
+  case 'i':
+    return sizeof(int32_t);
+  case 'f':
+  case 'd':
+    return sizeof(double);
+  case 'c':
+    return sizeof(char);
+  default:
+    return 0;
+  }
+}
+
+// split a "a,b,c" header into column names
+inline std::vector<std::string> splitHeader(const std::string &header) {
+  std::vector<std::string> names;
+  size_t begin = 0;
+  for (;;) {
+    size_t end = header.find(',', begin);
+    names.push_back(header.substr(begin, end - begin));
+    if (end == std::string::npos)
+      break;
+    begin = end + 1;
+  }
+  return names;
+}
+} // namespace AnnResultBin
+
+class AnnResultBinWriter {
+public:
+  // <header> names the columns and <fmt> gives their types, as passed to
+  // AnnResultWriter::writeRow()
+  AnnResultBinWriter(const std::string &filename, const std::string &header,
+                     const std::string &fmt, bool allowOverwrite = false,
+                     size_t blockRows = AnnResultBin::DefaultBlockRows)
+      : _fp(nullptr), _filename_cp(filename), _fmt(fmt),
+        _block_rows(blockRows), _rows(0) {
+    auto names = AnnResultBin::splitHeader(header);
+    if (names.size() != fmt.size())
+      throw std::runtime_error("AnnResultBinWriter::AnnResultBinWriter(): "
+                               "header \"" +
+                               header + "\" does not match format \"" + fmt +
+                               "\"");
+    for (char t : fmt)
+      if (AnnResultBin::typeSize(t) == 0)
+        throw std::runtime_error("AnnResultBinWriter::AnnResultBinWriter(): "
+                                 "Unsupported format \'" +
+                                 std::string(1, t) + "\'");
+    if (blockRows == 0)
+      throw std::runtime_error(
+          "AnnResultBinWriter::AnnResultBinWriter(): blockRows must be > 0");
+    if (!allowOverwrite && _exists()) {
+      throw npp::Exception("AnnResultBinWriter::AnnResultBinWriter(): file " +
+                               _filename_cp + " already exists",
+                           __FILE__, __LINE__);
+    }
+    if ((_fp = fopen(_filename_cp.c_str(), "wb")) == nullptr)
+      throw std::runtime_error(
+          "AnnResultBinWriter::AnnResultBinWriter(): Failed to open file " +
+          _filename_cp);
+
+    _columns.resize(fmt.size());
+    for (size_t j = 0; j < fmt.size(); ++j)
+      _columns[j].resize(blockRows * AnnResultBin::typeSize(fmt[j]));
+
+    uint32_t version = AnnResultBin::Version;
+    uint32_t numCols = static_cast<uint32_t>(fmt.size());
+    bool ok = fwrite(AnnResultBin::Magic, sizeof(AnnResultBin::Magic), 1,
+                     _fp) == 1 &&
+              fwrite(&version, sizeof(version), 1, _fp) == 1 &&
+              fwrite(&numCols, sizeof(numCols), 1, _fp) == 1;
+    for (size_t j = 0; ok && j < names.size(); ++j) {
+      uint16_t len = static_cast<uint16_t>(names[j].size());
+      ok = fputc(fmt[j], _fp) != EOF &&
+           fwrite(&len, sizeof(len), 1, _fp) == 1 &&
+           fwrite(names[j].data(), 1, len, _fp) == len;
+    }
+    if (!ok) {
+      fclose(_fp);
+      _fp = nullptr;
+      throw std::runtime_error(
+          "AnnResultBinWriter::AnnResultBinWriter(): Failed to write file " +
+          _filename_cp);
+    }
+  }
+
+  AnnResultBinWriter(const AnnResultBinWriter &) = delete;
+  AnnResultBinWriter &operator=(const AnnResultBinWriter &) = delete;
+
+  ~AnnResultBinWriter() {
+    if (_fp) {
+      flush();
+      fclose(_fp);
+    }
+  }
+
+  // same calling convention as AnnResultWriter::writeRow(), <fmt> must be the
+  // format given to the constructor
+  bool writeRow(const char *fmt, ...) {
+    if (_fmt != fmt)
+      throw std::runtime_error("AnnResultBinWriter::writeRow(): format \"" +
+                               std::string(fmt) + "\" does not match \"" +
+                               _fmt + "\"");
+    va_list args;
+    va_start(args, fmt);
+    for (size_t j = 0; j < _fmt.size(); ++j) {
+      switch (_fmt[j]) {
+      case 'i':
+        _append(j, static_cast<int32_t>(va_arg(args, int)));
+        break;
+      case 'f':
+      case 'd':
+        _append(j, va_arg(args, double));
+        break;
+      case 'c':
+        _append(j, static_cast<char>(va_arg(args, int)));
+        break;
+      }
+    }
+    va_end(args);
+    if (++_rows == _block_rows)
+      return flush();
+    return true;
+  }
+
+  // write the buffered rows as one block
+  bool flush() {
+    if (_rows == 0)
+      return true;
+    uint32_t rows = static_cast<uint32_t>(_rows);
+    bool success = fwrite(&rows, sizeof(rows), 1, _fp) == 1;
+    for (size_t j = 0; success && j < _columns.size(); ++j) {
+      size_t bytes = _rows * AnnResultBin::typeSize(_fmt[j]);
+      success = fwrite(_columns[j].data(), 1, bytes, _fp) == bytes;
+    }
+    _rows = 0;
+#ifdef DEBUG
+    if (!success)
+      perror("AnnResultBinWriter::flush() failed.\nError: ");
+#endif
+    return success;
+  }
+
+private:
+  template <typename T> void _append(size_t j, T val) {
+    std::memcpy(_columns[j].data() + _rows * sizeof(T), &val, sizeof(T));
+  }
+  bool _exists() const {
+    FILE *fp = fopen(_filename_cp.c_str(), "r");
+    bool ex = (fp != nullptr);
+    if (ex)
+      fclose(fp);
+
+    return ex;
+  }
+  FILE *_fp;
+  std::string _filename_cp;
+  std::string _fmt;
+  size_t _block_rows;
+  size_t _rows; // buffered
+  std::vector<std::vector<char>> _columns; // blockRows values each
+};
+
+// reads a whole binary result file into one array per column
+class AnnResultBinReader {
+public:
+  AnnResultBinReader(const std::string &filename) : _rows(0) {
+    FILE *fp = fopen(filename.c_str(), "rb");
+    if (fp == nullptr)
+      throw std::runtime_error(
+          "AnnResultBinReader::AnnResultBinReader(): Failed to open file " +
+          filename);
+    try {
+      _read(fp, filename);
+    } catch (...) {
+      fclose(fp);
+      throw;
+    }
+    fclose(fp);
+  }
+
+  size_t numRows() const { return _rows; }
+  size_t numColumns() const { return _fmt.size(); }
+  // column types, e.g., "iiiiiffi"
+  const std::string &format() const { return _fmt; }
+  const std::vector<std::string> &names() const { return _names; }
+  // comma separated column names as written by AnnResultWriter
+  std::string header() const {
+    std::string h;
+    for (size_t j = 0; j < _names.size(); ++j)
+      h += (j == 0 ? "" : ",") + _names[j];
+    return h;
+  }
+
+  // index of the column <name>
+  size_t columnIndex(const std::string &name) const {
+    for (size_t j = 0; j < _names.size(); ++j)
+      if (_names[j] == name)
+        return j;
+    throw std::runtime_error("AnnResultBinReader::columnIndex(): no column " +
+                             name);
+  }
+
+  // values of the j-th column, T must match its type
+  template <typename T> std::vector<T> column(size_t j) const {
+    if (j >= _fmt.size() || sizeof(T) != AnnResultBin::typeSize(_fmt[j]))
+      throw std::runtime_error(
+          "AnnResultBinReader::column(): type does not match column " +
+          std::to_string(j));
+    std::vector<T> values(_rows);
+    if (_rows > 0)
+      std::memcpy(values.data(), _data[j].data(), _rows * sizeof(T));
+    return values;
+  }
+  template <typename T> std::vector<T> column(const std::string &name) const {
+    return column<T>(columnIndex(name));
+  }
+
+  // write the rows in the text format of AnnResultWriter, i.e., the header
+  // line followed by one comma separated line per row
+  void toCsv(const std::string &output) const {
+    FILE *fp = fopen(output.c_str(), "w");
+    if (fp == nullptr)
+      throw std::runtime_error(
+          "AnnResultBinReader::toCsv(): Failed to open file " + output);
+    bool ok = fprintf(fp, "%s\n", header().c_str()) >= 0;
+    for (size_t r = 0; ok && r < _rows; ++r) {
+      for (size_t j = 0; ok && j < _fmt.size(); ++j) {
+        const char *sep = (j == 0 ? "" : ",");
+        const char *p = _data[j].data() + r * AnnResultBin::typeSize(_fmt[j]);
+        if (_fmt[j] == 'i') {
+          int32_t v;
+          std::memcpy(&v, p, sizeof(v));
+          ok = fprintf(fp, "%s%d", sep, v) >= 0;
+        } else if (_fmt[j] == 'c') {
+          ok = fprintf(fp, "%s%c", sep, *p) >= 0;
+        } else {
+          double v;
+          std::memcpy(&v, p, sizeof(v));
+          ok = fprintf(fp, "%s%.6f", sep, v) >= 0;
+        }
+      }
+      ok = ok && fprintf(fp, "\n") >= 0;
+    }
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok)
+      throw std::runtime_error(
+          "AnnResultBinReader::toCsv(): Failed to write file " + output);
+  }
+
+private:
+  void _read(FILE *fp, const std::string &filename) {
+    auto fail = [&]() {
+      throw std::runtime_error("AnnResultBinReader::AnnResultBinReader(): " +
+                               filename + " is not a valid result file");
+    };
+    char magic[sizeof(AnnResultBin::Magic)];
+    uint32_t version, numCols;
+    if (fread(magic, sizeof(magic), 1, fp) != 1 ||
+        std::memcmp(magic, AnnResultBin::Magic, sizeof(magic)) != 0 ||
+        fread(&version, sizeof(version), 1, fp) != 1 ||
+        version != AnnResultBin::Version ||
+        fread(&numCols, sizeof(numCols), 1, fp) != 1)
+      fail();
+    for (uint32_t j = 0; j < numCols; ++j) {
+      int type = fgetc(fp);
+      uint16_t len;
+      if (type == EOF || AnnResultBin::typeSize(static_cast<char>(type)) == 0 ||
+          fread(&len, sizeof(len), 1, fp) != 1)
+        fail();
+      std::string name(len, '\0');
+      if (len > 0 && fread(&name[0], 1, len, fp) != len)
+        fail();
+      _fmt.push_back(static_cast<char>(type));
+      _names.push_back(name);
+    }
+    _data.resize(numCols);
+
+    uint32_t rows;
+    while (fread(&rows, sizeof(rows), 1, fp) == 1) {
+      for (uint32_t j = 0; j < numCols; ++j) {
+        size_t bytes = rows * AnnResultBin::typeSize(_fmt[j]);
+        size_t pos = _data[j].size();
+        _data[j].resize(pos + bytes);
+        if (fread(_data[j].data() + pos, 1, bytes, fp) != bytes)
+          fail(); // truncated block
+      }
+      _rows += rows;
+    }
+  }
+
+  size_t _rows;
+  std::string _fmt;
+  std::vector<std::string> _names;
+  std::vector<std::vector<char>> _data; // raw column arrays
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+#include "AnnResultBin.hpp"
+#include "AnnResultWriter.hpp"
+#include "Exception.h"
+#include "Timer.hpp"
+
+using namespace npp;
+using namespace AnnResults;
+
+std::string slurp(const char *filename) {
+  std::ifstream in(filename);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+int main() {
+  try {
+    NPP_ASSERT(AnnResultBin::splitHeader("a,b,,c") ==
+               std::vector<std::string>({"a", "b", "", "c"}));
+    const int nq = 1000, k = 100;
+    HighResolutionTimer timer;
+    {
+      // the same rows through both writers, blocks of 777 rows
+      AnnResultWriter text("ann-result-bin-test.txt", true);
+      AnnResultBinWriter bin("ann-result-bin-test.bin", _DEFAULT_HEADER_E_,
+                             _DEFAULT_FMT_E_, true, 777);
+      NPP_ASSERT(text.writeRow("s", _DEFAULT_HEADER_E_));
+      auto writeAll = [&](auto &writer) {
+        for (int q = 0; q < nq; ++q) {
+          for (int i = 0; i < k; ++i) {
+            int rid = (q * 7919 + i * 104729) % 1000000, rd = 100 + i,
+                gd = 90 + i;
+            double ratio = static_cast<double>(rd) / gd, qt = 1.5 * q + 0.123;
+            NPP_ASSERT(writer.writeRow(_DEFAULT_FMT_E_, q, i, rid, rd, gd,
+                                       ratio, qt, i % 5));
+          }
+        }
+      };
+      timer.restart();
+      writeAll(text);
+      auto eText = timer.elapsed();
+      timer.restart();
+      writeAll(bin);
+      auto eBin = timer.elapsed();
+      std::cout << nq * k << " rows, text: " << eText << " us, binary: "
+                << eBin << " us" << std::endl;
+    }
+
+    AnnResultBinReader reader("ann-result-bin-test.bin");
+    NPP_ASSERT(reader.numRows() == size_t(nq) * k);
+    NPP_ASSERT(reader.header() == _DEFAULT_HEADER_E_);
+    NPP_ASSERT(reader.format() == _DEFAULT_FMT_E_);
+    auto qid = reader.column<int32_t>("#qid");
+    auto ratio = reader.column<double>("ratio");
+    NPP_ASSERT(qid[0] == 0 && qid[k] == 1 && qid.back() == nq - 1);
+    NPP_ASSERT(ratio[1] == 101.0 / 91);
+    bool thrown = false;
+    try {
+      reader.column<double>("#qid"); // wrong type
+    } catch (const std::runtime_error &) {
+      thrown = true;
+    }
+    NPP_ASSERT(thrown);
+
+    // converting back gives exactly the text output
+    reader.toCsv("ann-result-bin-test.csv");
+    NPP_ASSERT(slurp("ann-result-bin-test.csv") ==
+               slurp("ann-result-bin-test.txt"));
+
+    {
+      // a header without rows, and 'c' columns
+      AnnResultBinWriter bin("ann-result-bin-test.bin", "x,y", "cf", true);
+    }
+    NPP_ASSERT(AnnResultBinReader("ann-result-bin-test.bin").numRows() == 0);
+    {
+      AnnResultBinWriter bin("ann-result-bin-test.bin", "x,y", "cf", true);
+      NPP_ASSERT(bin.writeRow("cf", 'a', 0.5));
+      NPP_ASSERT(bin.flush());
+      NPP_ASSERT(bin.writeRow("cf", 'b', 1.25));
+    }
+    AnnResultBinReader("ann-result-bin-test.bin")
+        .toCsv("ann-result-bin-test.csv");
+    NPP_ASSERT(slurp("ann-result-bin-test.csv") ==
+               "x,y\na,0.500000\nb,1.250000\n");
+
+    thrown = false;
+    try {
+      AnnResultBinWriter bin("ann-result-bin-test.bin", "x,y", "iii", true);
+    } catch (const std::runtime_error &) {
+      thrown = true;
+    }
+    NPP_ASSERT(thrown);
+    thrown = false;
+    try {
+      AnnResultBinWriter bin("ann-result-bin-test.bin", "x,y", "cf");
+    } catch (const Exception &) {
+      thrown = true; // exists
+    }
+    NPP_ASSERT(thrown);
+
+    // a truncated block is detected
+    {
+      AnnResultBinWriter bin("ann-result-bin-test.bin", "x", "i", true);
+      for (int i = 0; i < 10; ++i)
+        bin.writeRow("i", i);
+    }
+    NPP_ASSERT(truncate("ann-result-bin-test.bin",
+                        slurp("ann-result-bin-test.bin").size() - 1) == 0);
+    thrown = false;
+    try {
+      AnnResultBinReader truncated("ann-result-bin-test.bin");
+    } catch (const std::runtime_error &) {
+      thrown = true;
+    }
+    NPP_ASSERT(thrown);
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  remove("ann-result-bin-test.txt");
+  remove("ann-result-bin-test.bin");
+  remove("ann-result-bin-test.csv");
+  return EXIT_SUCCESS;
+}
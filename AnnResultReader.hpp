@@ -0,0 +1,245 @@
+#ifndef __ANNRESULT_READER_HPP__
+#define __ANNRESULT_READER_HPP__
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "ParallelUtils.hpp"
+
+// reader of the text files written by AnnResultWriter, i.e., a header line of
+// column names followed by comma separated rows, into one array per column.
+// The file is memory-mapped and split at line boundaries into chunks parsed
+// by several threads with std::from_chars: a first pass counts the rows of
+// every chunk, so the second one writes the values straight to their place.
+// Columns hold integers ('i', stored as int64_t) or floating point values
+// ('f'/'d', stored as double), as given by the format of the writer or
+// guessed from the first row.
+class AnnResultReader {
+public:
+  // <fmt> is the format passed to AnnResultWriter::writeRow(), e.g.,
+  // AnnResults::_DEFAULT_FMT_E_, or empty to guess it
+  explicit AnnResultReader(const std::string &filename,
+                           const std::string &fmt = "",
+                           unsigned numThreads = 0)
+      : _filename(filename), _fmt(fmt), _rows(0) {
+    MappedFile file(filename);
+    file.advise(MappedFile::Sequential);
+    const char *p = file.data(), *end = p + file.size();
+    const char *eol = _lineEnd(p, end);
+    _names = _split(std::string(p, _trimCr(p, eol) - p));
+    p = (eol == end) ? end : eol + 1;
+    _parse(p, end, numThreads);
+  }
+
+  size_t numRows() const { return _rows; }
+  size_t numColumns() const { return _names.size(); }
+  // column types, e.g., "iiiiiffi"
+  const std::string &format() const { return _fmt; }
+  const std::vector<std::string> &names() const { return _names; }
+  // comma separated column names, i.e., the first line
+  std::string header() const {
+    std::string h;
+    for (size_t j = 0; j < _names.size(); ++j)
+      h += (j == 0 ? "" : ",") + _names[j];
+    return h;
+  }
+
+  bool hasColumn(const std::string &name) const {
+    return std::find(_names.begin(), _names.end(), name) != _names.end();
+  }
+  // index of the column <name>
+  size_t columnIndex(const std::string &name) const {
+    for (size_t j = 0; j < _names.size(); ++j)
+      if (_names[j] == name)
+        return j;
+    throw std::runtime_error("AnnResultReader::columnIndex(): no column " +
+                             name + " in " + _filename);
+  }
+
+  // values of an integer or floating point column as parsed
+  const std::vector<int64_t> &ints(size_t j) const {
+    if (j >= _fmt.size() || _fmt[j] != 'i')
+      throw std::runtime_error(
+          "AnnResultReader::ints(): not an integer column " +
+          std::to_string(j));
+    return _ints[j];
+  }
+  const std::vector<double> &floats(size_t j) const {
+    if (j >= _fmt.size() || _fmt[j] == 'i')
+      throw std::runtime_error(
+          "AnnResultReader::floats(): not a floating point column " +
+          std::to_string(j));
+    return _floats[j];
+  }
+
+  // values of the j-th column converted to T
+  template <typename T> std::vector<T> column(size_t j) const {
+    if (j >= _fmt.size())
+      throw std::runtime_error("AnnResultReader::column(): no column " +
+                               std::to_string(j));
+    if (_fmt[j] == 'i')
+      return std::vector<T>(_ints[j].begin(), _ints[j].end());
+    return std::vector<T>(_floats[j].begin(), _floats[j].end());
+  }
+  template <typename T> std::vector<T> column(const std::string &name) const {
+    return column<T>(columnIndex(name));
+  }
+
+private:
+  // chunks of at least MinChunk bytes, about 4 per thread
+  static constexpr size_t MinChunk = 1u << 16;
+
+  static const char *_lineEnd(const char *p, const char *end) {
+    auto q = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    return q ? q : end;
+  }
+  static const char *_trimCr(const char *begin, const char *eol) {
+    return (eol > begin && eol[-1] == '\r') ? eol - 1 : eol;
+  }
+  static std::vector<std::string> _split(const std::string &line) {
+    std::vector<std::string> names;
+    size_t begin = 0;
+    for (;;) {
+      size_t end = line.find(',', begin);
+      names.push_back(line.substr(begin, end - begin));
+      if (end == std::string::npos)
+        break;
+      begin = end + 1;
+    }
+    return names;
+  }
+
+  // call fn(begin, end) for the non-empty lines in [p, end), without the
+  // line breaks
+  template <typename Fn>
+  static void _forEachLine(const char *p, const char *end, Fn fn) {
+    while (p < end) {
+      const char *eol = _lineEnd(p, end);
+      const char *last = _trimCr(p, eol);
+      if (last > p)
+        fn(p, last);
+      p = eol + 1;
+    }
+  }
+
+  void _parse(const char *data, const char *end, unsigned numThreads) {
+    const size_t numCols = _names.size();
+    if (_fmt.empty())
+      _guessFormat(data, end);
+    if (_fmt.size() != numCols)
+      throw std::runtime_error("AnnResultReader::AnnResultReader(): format \"" +
+                               _fmt + "\" does not match the header of " +
+                               _filename);
+    for (char t : _fmt)
+      if (t != 'i' && t != 'f' && t != 'd')
+        throw std::runtime_error(
+            "AnnResultReader::AnnResultReader(): Unsupported format \'" +
+            std::string(1, t) + "\'");
+
+    // chunk boundaries, each chunk starts at the beginning of a line
+    if (numThreads == 0)
+      numThreads = ParallelUtils::defaultThreads();
+    size_t size = end - data;
+    size_t numChunks = std::max<size_t>(
+        1, std::min<size_t>(size / MinChunk, 4 * size_t(numThreads)));
+    std::vector<const char *> bounds(numChunks + 1, end);
+    bounds[0] = data;
+    for (size_t c = 1; c < numChunks; ++c) {
+      const char *p = std::max(data + size / numChunks * c, bounds[c - 1]);
+      if (p > data && p[-1] != '\n') {
+        p = _lineEnd(p, end);
+        if (p < end)
+          ++p;
+      }
+      bounds[c] = p;
+    }
+
+    // first row of every chunk
+    std::vector<size_t> first(numChunks + 1, 0);
+    ParallelUtils::parallelFor(
+        numChunks, numThreads, [&](size_t begin, size_t stop, unsigned) {
+          for (size_t c = begin; c < stop; ++c)
+            _forEachLine(bounds[c], bounds[c + 1],
+                         [&](const char *, const char *) { ++first[c + 1]; });
+        });
+    for (size_t c = 0; c < numChunks; ++c)
+      first[c + 1] += first[c];
+    _rows = first[numChunks];
+
+    _ints.assign(numCols, {});
+    _floats.assign(numCols, {});
+    for (size_t j = 0; j < numCols; ++j) {
+      if (_fmt[j] == 'i')
+        _ints[j].resize(_rows);
+      else
+        _floats[j].resize(_rows);
+    }
+
+    ParallelUtils::parallelFor(
+        numChunks, numThreads, [&](size_t begin, size_t stop, unsigned) {
+          for (size_t c = begin; c < stop; ++c) {
+            size_t row = first[c];
+            _forEachLine(bounds[c], bounds[c + 1],
+                         [&](const char *p, const char *last) {
+                           _parseRow(p, last, row++);
+                         });
+          }
+        });
+  }
+
+  // parse one line into row <row> of the columns
+  void _parseRow(const char *p, const char *last, size_t row) {
+    for (size_t j = 0; j < _fmt.size(); ++j) {
+      std::from_chars_result r;
+      if (_fmt[j] == 'i')
+        r = std::from_chars(p, last, _ints[j][row]);
+      else
+        r = std::from_chars(p, last, _floats[j][row]);
+      bool ok = r.ec == std::errc();
+      if (j + 1 < _fmt.size())
+        ok = ok && r.ptr != last && *r.ptr == ',';
+      else
+        ok = ok && r.ptr == last;
+      if (!ok)
+        throw std::runtime_error("AnnResultReader::AnnResultReader(): bad "
+                                 "value in column " +
+                                 _names[j] + " of row " + std::to_string(row) +
+                                 " in " + _filename);
+      p = r.ptr + 1;
+    }
+  }
+
+  // integers where the first row has one, floating point values otherwise
+  void _guessFormat(const char *data, const char *end) {
+    const char *p = data, *eol = _lineEnd(p, end);
+    while (p < end && _trimCr(p, eol) == p) { // skip empty lines
+      p = eol + 1;
+      eol = p < end ? _lineEnd(p, end) : end;
+    }
+    const char *last = _trimCr(p, eol);
+    for (size_t j = 0; j < _names.size(); ++j) {
+      const char *comma = static_cast<const char *>(
+          std::memchr(p, ',', last > p ? last - p : 0));
+      const char *tokenEnd = comma ? comma : last;
+      int64_t v;
+      auto r = std::from_chars(p, tokenEnd, v);
+      _fmt += (r.ec == std::errc() && r.ptr == tokenEnd) ? 'i' : 'f';
+      p = comma ? comma + 1 : last;
+    }
+  }
+
+  std::string _filename;
+  std::string _fmt;
+  size_t _rows;
+  std::vector<std::string> _names;
+  std::vector<std::vector<int64_t>> _ints;  // empty for 'f' columns
+  std::vector<std::vector<double>> _floats; // empty for 'i' columns
+};
+
+#endif
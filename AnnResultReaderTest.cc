@@ -0,0 +1,108 @@
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "AnnResultReader.hpp"
+#include "AnnResultWriter.hpp"
+#include "Exception.h"
+#include "Timer.hpp"
+#include "TypedAnnResultWriter.hpp"
+
+using namespace npp;
+using namespace AnnResults;
+
+const char *FILE_NAME = "ann-result-reader-test.txt";
+
+void writeText(const char *text) {
+  FILE *fp = fopen(FILE_NAME, "wb");
+  NPP_ASSERT_NOT_NULL(fp);
+  fputs(text, fp);
+  fclose(fp);
+}
+
+bool throws(const char *text, const char *fmt = "") {
+  writeText(text);
+  try {
+    AnnResultReader reader(FILE_NAME, fmt);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+int main() {
+  try {
+    // a million rows of the default format
+    const size_t n = 1000000;
+    std::mt19937 gen(2020);
+    std::uniform_int_distribution<int> ints(-2000000000, 2000000000);
+    std::uniform_real_distribution<double> reals(-1e4, 1e4);
+    std::vector<DefaultWriterE::Row> rows(n);
+    {
+      DefaultWriterE writer(FILE_NAME, true);
+      writer.writeHeader(_DEFAULT_HEADER_E_);
+      for (size_t i = 0; i < n; ++i) {
+        rows[i] = DefaultWriterE::Row(int(i / 100), int(i % 100), ints(gen),
+                                      ints(gen), ints(gen), reals(gen),
+                                      std::abs(reals(gen)), ints(gen) % 1000);
+        writer.writeRow(rows[i]);
+      }
+    }
+
+    for (unsigned threads : {1u, 4u}) {
+      HighResolutionTimer timer;
+      timer.restart();
+      AnnResultReader reader(FILE_NAME, _DEFAULT_FMT_E_, threads);
+      auto e = timer.elapsed();
+      MappedFile file(FILE_NAME);
+      std::cout << threads << " threads: " << file.size() / e << " MB/s"
+                << std::endl;
+
+      NPP_ASSERT(reader.numRows() == n && reader.numColumns() == 8);
+      NPP_ASSERT(reader.header() == _DEFAULT_HEADER_E_);
+      NPP_ASSERT(reader.format() == _DEFAULT_FMT_E_);
+      auto qids = reader.column<int>("#qid");
+      auto rids = reader.ints(2);
+      auto ratios = reader.floats(reader.columnIndex("ratio"));
+      auto ios = reader.column<int>(7);
+      for (size_t i = 0; i < n; ++i) {
+        NPP_ASSERT(qids[i] == std::get<0>(rows[i]));
+        NPP_ASSERT(rids[i] == std::get<2>(rows[i]));
+        NPP_ASSERT(std::abs(ratios[i] - std::get<5>(rows[i])) <= 5.1e-7);
+        NPP_ASSERT(ios[i] == std::get<7>(rows[i]));
+      }
+    }
+
+    // guessed format, CRLF line breaks and empty lines as in the demo
+    writeText("#qid,#kid,#rid,rdist,gdist\r\n"
+              "1,1,100,12.000000,10.000000\r\n"
+              "\r\n"
+              "1,2,111,21.000000,-1e3\r\n"
+              "2,1,-201,nan,11");
+    {
+      AnnResultReader reader(FILE_NAME);
+      NPP_ASSERT(reader.format() == "iiiff" && reader.numRows() == 3);
+      NPP_ASSERT(reader.column<int>("#rid") == std::vector<int>({100, 111,
+                                                                 -201}));
+      NPP_ASSERT(reader.column<double>("gdist") ==
+                 std::vector<double>({10, -1000, 11}));
+      NPP_ASSERT(std::isnan(reader.floats(3)[2]));
+      NPP_ASSERT(!reader.hasColumn("ratio"));
+    }
+    writeText("#qid,ratio\n");
+    NPP_ASSERT(AnnResultReader(FILE_NAME).numRows() == 0);
+
+    NPP_ASSERT(throws("a,b\n1,2.5\n", "ii"));   // not an integer
+    NPP_ASSERT(throws("a,b\n1,2\n3\n"));        // missing value
+    NPP_ASSERT(throws("a,b\n1,2,3\n"));         // extra value
+    NPP_ASSERT(throws("a,b\n1,x\n", "if"));     // not a number
+    NPP_ASSERT(throws("a,b\n1,2\n", "iii"));    // too many types
+    NPP_ASSERT(throws("a,b\n1,a\n", "ic"));     // unsupported type
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  remove(FILE_NAME);
+  return EXIT_SUCCESS;
+}
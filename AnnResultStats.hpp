@@ -0,0 +1,159 @@
+#ifndef __ANNRESULT_STATS_HPP__
+#define __ANNRESULT_STATS_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+
+// running count, mean and variance of a stream of values (Welford), merged
+// with the pairwise update of Chan et al.
+class RunningStat {
+public:
+  RunningStat() : _n(0), _mean(0), _m2(0) {}
+
+  void add(double x) {
+    ++_n;
+    double d = x - _mean;
+    _mean += d / _n;
+    _m2 += d * (x - _mean);
+  }
+
+  void merge(const RunningStat &other) {
+    if (other._n == 0)
+      return;
+    size_t n = _n + other._n;
+    double d = other._mean - _mean;
+    _mean += d * other._n / n;
+    _m2 += other._m2 + d * d * (static_cast<double>(_n) * other._n / n);
+    _n = n;
+  }
+
+  size_t count() const { return _n; }
+  double mean() const { return _mean; }
+  double variance() const { return _n < 2 ? 0 : _m2 / (_n - 1); }
+  double stddev() const { return std::sqrt(variance()); }
+
+private:
+  size_t _n;
+  double _mean;
+  double _m2; // sum of squared differences from the mean
+};
+
+// aggregates of the AnnResultWriter columns (#qid, #kid, #rid, rdist, gdist,
+// ratio, qtime(us) and #io) computed on the fly instead of writing one line
+// per row: mean ratio, recall@k, mean I/Os and query time percentiles. Each
+// worker thread feeds its own AnnResultStats with the rows of its queries,
+// one query after the other, and the per-thread results are merged at the
+// end. A result counts as a hit of recall@k if its rdist is not above the
+// gdist of the k-th true neighbor, i.e., the last row of the query.
+class alignas(64) AnnResultStats {
+public:
+  AnnResultStats()
+      : _queries(0), _rows(0), _hits(0), _k(0), _open(false), _pending_qid(-1),
+        _pending_gdist(0) {}
+
+  // one row, same values as passed to AnnResultWriter::writeRow()
+  void add(int qid, int kid, int rid, int rdist, int gdist, double ratio,
+           double qtime, int io = 0) {
+    (void)kid;
+    (void)rid;
+    if (!_open || qid != _pending_qid)
+      _startQuery(qid, qtime, io);
+    _pending.push_back(rdist);
+    _pending_gdist = gdist;
+    _ratio.add(ratio);
+    ++_rows;
+  }
+
+  // fold the rows of another thread into this one. The open query of <other>
+  // is counted as if it ended now, and the open query of this object stays
+  // open. Merging the same <other> twice counts its rows and hits twice, and
+  // so does merging it before its open query ends and again afterwards for
+  // the hits of that query.
+  void merge(const AnnResultStats &other) {
+    _queries += other._queries;
+    _rows += other._rows;
+    _hits += other._hits + other._pendingHits();
+    _k = std::max({_k, other._k, other._pending.size()});
+    _ratio.merge(other._ratio);
+    _io.merge(other._io);
+    _qtime.merge(other._qtime);
+  }
+
+  // the accessors do not modify the object, so they may be called while a
+  // query is in progress; its rows count as they would if it ended here
+  size_t numQueries() const { return _queries; }
+  size_t numRows() const { return _rows; }
+  // largest number of rows of a query
+  size_t k() const { return std::max(_k, _pending.size()); }
+  double recall() const {
+    return _rows == 0 ? 0 : static_cast<double>(_hits + _pendingHits()) / _rows;
+  }
+  const RunningStat &ratio() const { return _ratio; }
+  const RunningStat &io() const { return _io; }
+  // query times in nanoseconds
+  const LatencyHistogram &qtime() const { return _qtime; }
+
+  // one line, e.g., for a parameter sweep
+  std::string summary() const {
+    const double us = 1e-3; // ns to us
+    char line[512];
+    snprintf(line, sizeof(line),
+             "queries=%zu rows=%zu recall@%zu=%.6f ratio=%.6f "
+             "qtime(us): mean=%.3f p50=%.3f p99=%.3f p999=%.3f max=%.3f "
+             "io=%.3f",
+             _queries, _rows, k(), recall(), _ratio.mean(), _qtime.mean() * us,
+             _qtime.percentile(50) * us, _qtime.percentile(99) * us,
+             _qtime.percentile(99.9) * us, _qtime.max() * us, _io.mean());
+    return line;
+  }
+
+private:
+  // qtime and #io are per query, so they are taken from its first row
+  void _startQuery(int qid, double qtime, int io) {
+    _closeQuery();
+    _open = true;
+    _pending_qid = qid;
+    _qtime.record(qtime > 0 ? static_cast<uint64_t>(std::llround(qtime * 1000))
+                            : 0);
+    _io.add(io);
+    ++_queries;
+  }
+
+  // hits of the pending query against the gdist of its last row so far
+  size_t _pendingHits() const {
+    size_t hits = 0;
+    for (int rdist : _pending)
+      if (rdist <= _pending_gdist)
+        ++hits;
+    return hits;
+  }
+
+  // count the hits of the pending query, once its last row is known
+  void _closeQuery() {
+    _hits += _pendingHits();
+    _k = std::max(_k, _pending.size());
+    _pending.clear();
+    _open = false;
+  }
+
+  size_t _queries;
+  size_t _rows;
+  size_t _hits; // of the closed queries
+  size_t _k;    // of the closed queries
+  RunningStat _ratio;
+  RunningStat _io;
+  LatencyHistogram _qtime;
+  // rows of the last query, whose hits are known after its last row
+  bool _open;
+  int _pending_qid;
+  int _pending_gdist;
+  std::vector<int> _pending;
+};
+
+#endif
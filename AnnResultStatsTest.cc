@@ -0,0 +1,114 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "AnnResultStats.hpp"
+#include "Exception.h"
+#include "Timer.hpp"
+
+using namespace npp;
+
+int main() {
+  try {
+    // welford against the two pass mean and variance, also merged
+    std::mt19937 gen(2020);
+    std::normal_distribution<double> normal(1e6, 3);
+    std::vector<double> xs(100001);
+    RunningStat all, first, second;
+    double sum = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+      xs[i] = normal(gen);
+      sum += xs[i];
+      all.add(xs[i]);
+      (i < 1234 ? first : second).add(xs[i]);
+    }
+    double mean = sum / xs.size(), ss = 0;
+    for (double x : xs)
+      ss += (x - mean) * (x - mean);
+    first.merge(second);
+    for (const RunningStat *s : {&all, &first}) {
+      NPP_ASSERT(s->count() == xs.size());
+      NPP_ASSERT(std::abs(s->mean() - mean) < 1e-6);
+      NPP_ASSERT(std::abs(s->variance() - ss / (xs.size() - 1)) < 1e-6);
+    }
+
+    // k = 10 results per query of which the i-th query gets i % 11 wrong,
+    // the rows of each query by one of 4 threads
+    const int numQueries = 20000, k = 10, numThreads = 4;
+    auto feed = [&](AnnResultStats &stats, int q) {
+      int wrong = q % 11 > k ? k : q % 11;
+      for (int i = 0; i < k; ++i) {
+        int gdist = 100 + i;
+        int rdist = i >= k - wrong ? 200 + i : gdist;
+        stats.add(q, i, q * k + i, rdist, gdist, double(rdist) / gdist,
+                  10 + q % 100, q % 3);
+      }
+    };
+    size_t hits = 0;
+    double ratioSum = 0;
+    for (int q = 0; q < numQueries; ++q) {
+      int wrong = q % 11 > k ? k : q % 11;
+      hits += k - wrong;
+      for (int i = 0; i < k; ++i)
+        ratioSum += i >= k - wrong ? double(200 + i) / (100 + i) : 1.0;
+    }
+
+    HighResolutionTimer timer;
+    AnnResultStats single;
+    timer.restart();
+    for (int q = 0; q < numQueries; ++q)
+      feed(single, q);
+    auto e = timer.elapsed();
+
+    std::vector<AnnResultStats> perThread(numThreads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; ++t)
+      workers.emplace_back([&, t]() {
+        for (int q = t; q < numQueries; q += numThreads)
+          feed(perThread[t], q);
+      });
+    for (auto &w : workers)
+      w.join();
+    AnnResultStats merged;
+    for (const auto &s : perThread)
+      merged.merge(s);
+
+    for (const AnnResultStats *s : {&single, &merged}) {
+      NPP_ASSERT(s->numQueries() == size_t(numQueries));
+      NPP_ASSERT(s->numRows() == size_t(numQueries) * k);
+      NPP_ASSERT(s->k() == size_t(k));
+      NPP_ASSERT(s->recall() == double(hits) / (numQueries * k));
+      NPP_ASSERT(std::abs(s->ratio().mean() - ratioSum / (numQueries * k)) <
+                 1e-9);
+      NPP_ASSERT(std::abs(s->io().mean() - 1.0) < 1e-3);
+      NPP_ASSERT(s->qtime().min() == 10000 && s->qtime().max() == 109000);
+      NPP_ASSERT(s->qtime().percentile(50) >= 59000 &&
+                 s->qtime().percentile(50) <= 59000 + 59000 / 128);
+    }
+    NPP_ASSERT(single.summary() == merged.summary());
+    std::cout << merged.summary() << std::endl;
+
+    // reading the stats in the middle of a query, e.g., to watch a run, does
+    // not split the query in two
+    AnnResultStats watched, unwatched;
+    for (int q = 0; q < 100; ++q) {
+      for (int i = 0; i < k; ++i) {
+        if (i == k / 2)
+          NPP_ASSERT(!watched.summary().empty() && watched.k() <= size_t(k));
+        int rdist = i == k - 1 ? 300 : 100 + i;
+        watched.add(q, i, i, rdist, 100 + i, 1.0, 10, 1);
+        unwatched.add(q, i, i, rdist, 100 + i, 1.0, 10, 1);
+      }
+    }
+    NPP_ASSERT(watched.numQueries() == 100 && watched.io().count() == 100 &&
+               watched.qtime().count() == 100);
+    NPP_ASSERT(watched.summary() == unwatched.summary());
+    NPP_ASSERT(watched.recall() == double(k - 1) / k);
+    std::cout << e * 1000 / (numQueries * k) << " ns per row" << std::endl;
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
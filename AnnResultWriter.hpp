@@ -7,8 +7,10 @@
 #include <cstdlib>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #include "Exception.h"
+#include "NumberFormat.hpp"
 
 namespace AnnResults {
 
@@ -24,7 +26,7 @@ const char * _DEFAULT_FMT_I_ = "iiiiiff";
 class AnnResultWriter {
 public:
   AnnResultWriter(const std::string &filename, bool allowOverwrite = false)
-      : _fp(nullptr), _filename_cp(filename) {
+      : _fp(nullptr), _filename_cp(filename), _buf(FlushSize + 4096) {
 #ifdef DEBUG
     fprintf(stdout, "Trying to open file %s\n", _filename_cp.c_str());
 #endif
@@ -45,15 +47,18 @@ public:
 #ifdef DEBUG
     fprintf(stdout, "Close file %s\n", _filename_cp.c_str());
 #endif
-    if (_fp)
+    if (_fp) {
+      flush();
       fclose(_fp);
+    }
   }
 
+  // rows are formatted into a buffer that is written to the file once it
+  // holds FlushSize bytes, by flush() or on destruction
   bool writeRow(const char *fmt, ...) {
     assert(_fp != nullptr && "File MUST be opened");
 
     int count = 0;
-    bool success = true;
     va_list args;
     va_start(args, fmt);
 
@@ -61,62 +66,68 @@ public:
       switch (*fmt) {
       case 'i': {
         int i = va_arg(args, int);
-        if (!_writeOne("%d", i, (count == 0)))
-          success = false;
+        _appendOne(i, (count == 0));
         break;
       }
       case 'f':
       case 'd': {
         double d = va_arg(args, double);
-        if (!_writeOne("%.6f", d, (count == 0)))
-          success = false;
+        _appendOne(d, (count == 0));
         break;
       }
       case 'c': {
         int c = va_arg(args, int);
-        if (!_writeOne("%c", c, (count == 0)))
-          success = false;
+        _appendOne(static_cast<char>(c), (count == 0));
         break;
       }
       case 's': {
         char *s = va_arg(args, char *);
-        if (!_writeOne("%s", s, (count == 0)))
-          success = false;
+        _appendOne(s ? s : "(null)", (count == 0));
         break;
       }
       default:
+        va_end(args);
         throw std::runtime_error("Unsupported format \'" +
                                  std::to_string(*fmt) + "\'\n");
       }
-      if (!success)
-        break;
       ++fmt;
       ++count;
     }
 
     va_end(args);
-    fprintf(_fp, "\n");
+    _buf.append('\n');
 
-    return success;
+    if (_buf.size() >= FlushSize)
+      return flush();
+    return true;
   }
 
-private:
-  template <typename AnyPrintableType>
-  bool _writeOne(const char *format, const AnyPrintableType &val,
-                 bool isFirst = false) {
-
-    int r1 = fprintf(_fp, "%s", (isFirst ? "" : ","));
-    int r2 = fprintf(_fp, format, val);
-
-    auto success = (r1 >= 0 && r2 >= 0);
+  // write the buffered rows to the file
+  bool flush() {
+    bool success = _buf.writeTo(_fp) && fflush(_fp) == 0;
 #ifdef DEBUG
     if (!success) {
-      perror("AnnResultWriter::_wrietOne() failed.\nError: ");
+      perror("AnnResultWriter::flush() failed.\nError: ");
     }
-
 #endif
     return success;
   }
+
+private:
+  static constexpr size_t FlushSize = 1u << 20;
+
+  // same text as printf() with "%d", "%.6f", "%c" and "%s"
+  template <typename AnyPrintableType>
+  void _appendOne(const AnyPrintableType &val, bool isFirst = false) {
+    if (!isFirst)
+      _buf.append(',');
+    if constexpr (std::is_same<AnyPrintableType, double>::value)
+      _buf.appendFixed(val, 6);
+    else if constexpr (std::is_same<AnyPrintableType, int>::value)
+      _buf.appendInt(val);
+    else
+      _buf.append(val);
+  }
   bool _exists() const {
     FILE *fp = fopen(_filename_cp.c_str(), "r");
     bool ex = (fp != nullptr);
@@ -127,6 +138,7 @@ private:
   }
   FILE *_fp;
   std::string _filename_cp;
+  CharBuffer _buf;
 };
 
 #endif
@@ -0,0 +1,231 @@
+#ifndef __ASYNC_ANNRESULT_HPP__
+#define __ASYNC_ANNRESULT_HPP__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+#include "TypedAnnResultWriter.hpp"
+
+// bounded lock-free queue of many producers and one consumer (D. Vyukov's
+// bounded MPMC queue with the consumer side simplified). Every cell carries a
+// sequence number telling whether it is free for the producer of ticket
+// <pos> (seq == pos) or holds the value of ticket <pos> (seq == pos + 1), so
+// producers only contend on one fetch of the enqueue ticket.
+template <typename T> class MpscRingBuffer {
+public:
+  // <capacity> is rounded up to a power of 2
+  explicit MpscRingBuffer(size_t capacity) : _enqueue_pos(0), _dequeue_pos(0) {
+    if (capacity == 0)
+      throw std::runtime_error(
+          "MpscRingBuffer::MpscRingBuffer(): capacity must be > 0");
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    _mask = size - 1;
+    _cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i)
+      _cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  MpscRingBuffer(const MpscRingBuffer &) = delete;
+  MpscRingBuffer &operator=(const MpscRingBuffer &) = delete;
+
+  size_t capacity() const { return _mask + 1; }
+
+  // any thread; false if the queue is full
+  template <typename... Args> bool tryPush(Args &&...args) {
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (;;) {
+      cell = &_cells[pos & _mask];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (dif == 0) {
+        if (_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed))
+          break;
+      } else if (dif < 0) {
+        return false;
+      } else {
+        pos = _enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = T(std::forward<Args>(args)...);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer thread only; false if the queue is empty or the next value is
+  // not completely pushed yet
+  bool tryPop(T &value) {
+    Cell &cell = _cells[_dequeue_pos & _mask];
+    if (cell.seq.load(std::memory_order_acquire) != _dequeue_pos + 1)
+      return false;
+    value = std::move(cell.value);
+    cell.seq.store(_dequeue_pos + _mask + 1, std::memory_order_release);
+    ++_dequeue_pos;
+    return true;
+  }
+
+  // number of values pushed or being pushed so far
+  size_t pushed() const { return _enqueue_pos.load(std::memory_order_acquire); }
+  // number of values popped so far, consumer thread only
+  size_t popped() const { return _dequeue_pos; }
+
+private:
+  struct alignas(64) Cell { // one per cache line, if T is small
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> _cells;
+  size_t _mask;
+  alignas(64) std::atomic<size_t> _enqueue_pos;
+  alignas(64) size_t _dequeue_pos;
+};
+
+// result writer shared by many threads: writeRow() copies the row into a
+// lock-free ring buffer and a background I/O thread formats and writes the
+// rows in batches, so the workers neither format text nor wait for each other
+// or for the disk. If the buffer is full writeRow() waits for the I/O thread
+// to catch up (backpressure). Rows of different threads are in no particular
+// order; the text of each row is the same as TypedAnnResultWriter's.
+// Remaining rows are written on destruction, which must happen after all
+// producers are done. Rows are written after writeRow() returns, so string
+// columns are std::string, copied into the queue, and not const char *.
+template <typename... Cols> class AsyncAnnResultWriter {
+  static_assert((!std::is_same<Cols, const char *>::value && ...),
+                "use std::string columns, the queued rows must own their text");
+
+public:
+  using Row = std::tuple<Cols...>;
+  static constexpr size_t NumColumns = sizeof...(Cols);
+
+  // <header> is written as the first line unless it is nullptr; <capacity>
+  // rows can be queued before producers have to wait
+  AsyncAnnResultWriter(const std::string &filename,
+                       const char *header = nullptr,
+                       bool allowOverwrite = false,
+                       size_t capacity = 1u << 16)
+      : _writer(filename, allowOverwrite), _queue(capacity), _stop(false),
+        _ok(true), _flush_target(0), _flushed(0), _stalls(0) {
+    if (header != nullptr)
+      _writer.writeHeader(header);
+    _io = std::thread(&AsyncAnnResultWriter::_run, this);
+  }
+
+  AsyncAnnResultWriter(const AsyncAnnResultWriter &) = delete;
+  AsyncAnnResultWriter &operator=(const AsyncAnnResultWriter &) = delete;
+
+  ~AsyncAnnResultWriter() {
+    _stop.store(true, std::memory_order_release);
+    if (_io.joinable())
+      _io.join();
+  }
+
+  // queue a row, waiting while the buffer is full; returns false once
+  // writing to the file failed
+  bool writeRow(const Cols &...vals) {
+    if (!_queue.tryPush(vals...)) {
+      _stalls.fetch_add(1, std::memory_order_relaxed);
+      do
+        std::this_thread::yield();
+      while (!_queue.tryPush(vals...));
+    }
+    return _ok.load(std::memory_order_relaxed);
+  }
+  bool writeRow(const Row &row) {
+    return std::apply([this](const Cols &...vals) { return writeRow(vals...); },
+                      row);
+  }
+
+  // queue a row unless the buffer is full
+  bool tryWriteRow(const Cols &...vals) { return _queue.tryPush(vals...); }
+
+  // wait until the rows queued so far are written to the file
+  bool flush() {
+    size_t target = _queue.pushed();
+    size_t cur = _flush_target.load(std::memory_order_relaxed);
+    while (cur < target &&
+           !_flush_target.compare_exchange_weak(cur, target,
+                                                std::memory_order_release))
+      ;
+    while (_flushed.load(std::memory_order_acquire) < target)
+      std::this_thread::yield();
+    return _ok.load(std::memory_order_relaxed);
+  }
+
+  // false once writing to the file failed
+  bool ok() const { return _ok.load(std::memory_order_relaxed); }
+  // number of rows that had to wait for a full buffer
+  size_t stalls() const { return _stalls.load(std::memory_order_relaxed); }
+  size_t capacity() const { return _queue.capacity(); }
+
+private:
+  // body of the I/O thread
+  void _run() {
+    unsigned idle = 0;
+    for (;;) {
+      bool stop = _stop.load(std::memory_order_acquire);
+      size_t n = _drain();
+      size_t target = _flush_target.load(std::memory_order_acquire);
+      if (target > _flushed.load(std::memory_order_relaxed) &&
+          _queue.popped() >= target) {
+        _check(_writer.flush());
+        _flushed.store(target, std::memory_order_release);
+      }
+      if (n > 0) {
+        idle = 0;
+      } else if (stop) {
+        break; // the producers were done before <_stop> was set
+      } else if (++idle < 64) {
+        std::this_thread::yield();
+      } else { // nothing to do for a while
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+    _check(_writer.flush());
+  }
+
+  // write the queued rows into the buffer of <_writer>
+  size_t _drain() {
+    size_t n = 0;
+    while (n < _queue.capacity() && _queue.tryPop(_row)) {
+      _check(_writer.writeRow(_row));
+      ++n;
+    }
+    return n;
+  }
+
+  void _check(bool ok) {
+    if (!ok)
+      _ok.store(false, std::memory_order_relaxed);
+  }
+
+  TypedAnnResultWriter<Cols...> _writer; // only used by the I/O thread
+  MpscRingBuffer<Row> _queue;
+  Row _row; // row being written
+  std::thread _io;
+  std::atomic<bool> _stop;
+  std::atomic<bool> _ok;
+  std::atomic<size_t> _flush_target; // rows to write before flushing
+  std::atomic<size_t> _flushed;      // rows written and flushed
+  std::atomic<size_t> _stalls;
+};
+
+namespace AnnResults {
+// asynchronous writers of the _DEFAULT_FMT_E_ and _DEFAULT_FMT_I_ columns
+using AsyncWriterE =
+    AsyncAnnResultWriter<int, int, int, int, int, double, double, int>;
+using AsyncWriterI =
+    AsyncAnnResultWriter<int, int, int, int, int, double, double>;
+} // namespace AnnResults
+
+#endif
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AnnResultWriter.hpp"
+#include "AsyncAnnResultWriter.hpp"
+#include "Exception.h"
+#include "Timer.hpp"
+
+using namespace npp;
+using namespace AnnResults;
+
+std::string slurp(const char *filename) {
+  std::ifstream in(filename);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+// lines of a file, sorted
+std::vector<std::string> sortedLines(const char *filename) {
+  std::ifstream in(filename);
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(in, line);)
+    lines.push_back(line);
+  std::sort(lines.begin(), lines.end());
+  return lines;
+}
+
+// row <i> of query <q>
+DefaultWriterE::Row makeRow(int q, int i) {
+  return DefaultWriterE::Row(q, i, q * 1000 + i, i * 3, i * 2, 1.0 + i / 64.0,
+                             q + 0.125, i % 5);
+}
+
+int main() {
+  try {
+    const int numThreads = 4, numQueries = 2000, k = 10;
+
+    // expected text, written by one thread
+    {
+      DefaultWriterE writer("async-ann-result-test.txt", true);
+      for (int q = 0; q < numQueries; ++q)
+        for (int i = 0; i < k; ++i)
+          writer.writeRow(makeRow(q, i));
+    }
+
+    // the queries split among the threads as the workers of a benchmark
+    // would; a small buffer makes the producers wait now and then
+    for (size_t capacity : {size_t(1u << 16), size_t(8)}) {
+      HighResolutionTimer timer;
+      size_t stalls;
+      {
+        AsyncWriterE writer("async-ann-result-test.async.txt",
+                            _DEFAULT_HEADER_E_, true, capacity);
+        NPP_ASSERT(writer.capacity() == capacity);
+        timer.restart();
+        std::atomic<int> failed(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < numThreads; ++t)
+          workers.emplace_back([&writer, &failed, t]() {
+            for (int q = t; q < numQueries; q += numThreads)
+              for (int i = 0; i < k; ++i)
+                if (!writer.writeRow(makeRow(q, i)))
+                  ++failed;
+          });
+        for (auto &w : workers)
+          w.join();
+        NPP_ASSERT(failed == 0);
+        stalls = writer.stalls();
+      } // the remaining rows are written here
+      auto e = timer.elapsed();
+      std::cout << "capacity " << capacity << ": " << numQueries * k
+                << " rows from " << numThreads << " threads, "
+                << e * 1000 / (numQueries * k) << " ns per row written, "
+                << stalls << " stalls" << std::endl;
+
+      auto expected = sortedLines("async-ann-result-test.txt");
+      expected.push_back(_DEFAULT_HEADER_E_);
+      std::sort(expected.begin(), expected.end());
+      NPP_ASSERT(sortedLines("async-ann-result-test.async.txt") == expected);
+      auto text = slurp("async-ann-result-test.async.txt");
+      NPP_ASSERT(text.compare(0, std::strlen(_DEFAULT_HEADER_E_) + 1,
+                              std::string(_DEFAULT_HEADER_E_) + "\n") == 0);
+    }
+
+    // flush() makes the rows queued so far visible in the file
+    {
+      AsyncAnnResultWriter<int, std::string> writer(
+          "async-ann-result-test.async.txt", nullptr, true, 4);
+      NPP_ASSERT(writer.writeRow(1, "a"));
+      NPP_ASSERT(writer.writeRow(std::make_tuple(2, "b")));
+      NPP_ASSERT(writer.flush());
+      NPP_ASSERT(slurp("async-ann-result-test.async.txt") == "1,a\n2,b\n");
+      NPP_ASSERT(writer.flush()); // nothing new
+      while (!writer.tryWriteRow(3, "c"))
+        ;
+    }
+    NPP_ASSERT(slurp("async-ann-result-test.async.txt") == "1,a\n2,b\n3,c\n");
+
+    bool thrown = false;
+    try {
+      AsyncWriterI writer("async-ann-result-test.txt");
+    } catch (const Exception &) {
+      thrown = true; // exists
+    }
+    NPP_ASSERT(thrown);
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  remove("async-ann-result-test.txt");
+  remove("async-ann-result-test.async.txt");
+  return EXIT_SUCCESS;
+}
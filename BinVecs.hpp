@@ -0,0 +1,265 @@
+#ifndef _BIN_VECS_HPP_
+#define _BIN_VECS_HPP_
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "VecsReader.h"
+#include "VecsView.hpp"
+
+// Compact cache of a vecs file (.fbin/.u8bin/.ibin): one 64-byte header
+// followed by the n x dim payload, row-major without per-row dim parts and
+// starting at an offset that is a multiple of <alignment>. Opening one is a
+// single mmap; the checksum is only computed by verify().
+namespace BinVecs {
+
+enum DType : uint32_t { Float32 = 1, UInt8 = 2, Int32 = 3 };
+
+template <typename T> struct DTypeOf;
+template <> struct DTypeOf<float> { static constexpr DType value = Float32; };
+template <> struct DTypeOf<uint8_t> { static constexpr DType value = UInt8; };
+template <> struct DTypeOf<int32_t> { static constexpr DType value = Int32; };
+
+inline size_t dtypeSize(uint32_t dtype) {
+  switch (dtype) {
+  case Float32:
+  case Int32:
+    return 4;
+  case UInt8:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// default payload alignment, i.e., a page
+constexpr uint32_t DefaultAlignment = 4096;
+constexpr char Magic[8] = {'V', 'E', 'C', 'S', 'B', 'I', 'N', '\0'};
+constexpr uint32_t Version = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t dtype;
+  uint64_t n;             // number of points
+  uint32_t dim;           // data dimension
+  uint32_t alignment;     // payload offset alignment
+  uint64_t payloadOffset; // first byte of the payload
+  uint64_t checksum;      // of the payload, see Checksum
+  char reserved[16];
+};
+static_assert(sizeof(Header) == 64, "header must be 64 bytes");
+
+// streaming 64-bit checksum: four multiply-rotate lanes over 8-byte words,
+// fast enough to run at memory bandwidth
+class Checksum {
+public:
+  Checksum() : _lanes{P1, P2, P3, P4}, _tail_sz(0), _total(0) {}
+
+  void update(const void *data, size_t len) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    _total += len;
+    while (_tail_sz > 0 && len > 0) { // finish a partial block first
+      _buf[_tail_sz++] = *p++;
+      --len;
+      if (_tail_sz == 32) {
+        _block(_buf);
+        _tail_sz = 0;
+      }
+    }
+    if (_tail_sz > 0)
+      return; // <data> did not complete the block
+    for (; len >= 32; p += 32, len -= 32)
+      _block(p);
+    std::memcpy(_buf, p, len);
+    _tail_sz = len;
+  }
+
+  uint64_t digest() const {
+    uint64_t h = _rotate(_lanes[0], 1) + _rotate(_lanes[1], 7) +
+                 _rotate(_lanes[2], 12) + _rotate(_lanes[3], 18);
+    for (size_t i = 0; i < _tail_sz; ++i)
+      h = (h ^ _buf[i]) * P1;
+    h ^= _total;
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    return h ^ (h >> 32);
+  }
+
+private:
+  static constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+  static constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+  static constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+  static constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+
+  static uint64_t _rotate(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+  }
+  void _block(const unsigned char *p) {
+    for (int i = 0; i < 4; ++i) {
+      uint64_t w;
+      std::memcpy(&w, p + 8 * i, 8);
+      _lanes[i] = _rotate(_lanes[i] + w * P2, 31) * P1;
+    }
+  }
+
+  uint64_t _lanes[4];
+  unsigned char _buf[32];
+  size_t _tail_sz;
+  uint64_t _total;
+};
+
+// cache file name for a vecs file, e.g., a/b.fvecs -> a/b.fbin
+inline std::string cacheName(const std::string &input) {
+  auto parts = FilenameUtils::pathextSplit(input);
+  auto ext = StringUtils::toLower(parts.second);
+  if (ext == ".fvecs")
+    return parts.first + ".fbin";
+  if (ext == ".bvecs")
+    return parts.first + ".u8bin";
+  if (ext == ".ivecs")
+    return parts.first + ".ibin";
+  throw VecsReaderException(__FILE__, __LINE__,
+                            "Unsupported vecs file \"" + input + "\"");
+}
+
+// convert the .fvecs/.bvecs/.ivecs file <input> into <output>, streaming it
+// in blocks; returns the number of points written
+inline size_t convert(const std::string &input, const std::string &output,
+                      uint32_t alignment = DefaultAlignment) {
+  VR_REQUIRED(alignment > 0 && alignment % sizeof(Header) == 0);
+  return visitVecsReader<float>(input, [&](auto &reader) {
+    using Elem = typename std::decay_t<decltype(reader)>::ElemType;
+    FILE *fp = fopen(output.c_str(), "wb");
+    VR_REQUIRED_MSG(fp != nullptr, "Opening \"" + output + "\" failed!");
+    std::unique_ptr<FILE, decltype(&fclose)> guard(fp, &fclose);
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, Magic, sizeof(Magic));
+    h.version = Version;
+    h.dtype = DTypeOf<Elem>::value;
+    h.n = reader.numPoints();
+    h.dim = reader.pointDimension();
+    h.alignment = alignment;
+    h.payloadOffset = alignment;
+    std::vector<char> pad(alignment - sizeof(Header), 0);
+    VR_REQUIRED(fwrite(&h, sizeof(h), 1, fp) == 1);
+    VR_REQUIRED(fwrite(pad.data(), 1, pad.size(), fp) == pad.size());
+
+    Checksum sum;
+    const size_t rowBytes = h.dim * sizeof(Elem);
+    const size_t block = std::max<size_t>(1, (16u << 20) / rowBytes);
+    std::vector<Elem> buf(block * h.dim);
+    size_t written = 0;
+    while (written < h.n) {
+      size_t m = reader.readInto(buf.data(), std::min(block, h.n - written));
+      VR_REQUIRED_MSG(m > 0, "Bad vecs file!");
+      size_t bytes = m * rowBytes;
+      VR_REQUIRED(fwrite(buf.data(), 1, bytes, fp) == bytes);
+      sum.update(buf.data(), bytes);
+      written += m;
+    }
+
+    h.checksum = sum.digest();
+    VR_REQUIRED(fseek(fp, 0, SEEK_SET) == 0);
+    VR_REQUIRED(fwrite(&h, sizeof(h), 1, fp) == 1);
+    VR_REQUIRED(fflush(fp) == 0);
+    return written;
+  });
+}
+} // namespace BinVecs
+
+// zero-copy reader of a BinVecs file holding elements of type T
+template <typename T> class BinVecsReader {
+public:
+  BinVecsReader(const char *filename)
+      : _filename(filename), _mapped(filename) {
+    VR_REQUIRED_MSG(_mapped.size() >= sizeof(BinVecs::Header),
+                    "\"" + _filename + "\" is too small");
+    std::memcpy(&_header, _mapped.data(), sizeof(_header));
+    VR_REQUIRED_MSG(std::memcmp(_header.magic, BinVecs::Magic,
+                                sizeof(BinVecs::Magic)) == 0,
+                    "\"" + _filename + "\" is not a BinVecs file");
+    VR_REQUIRED_MSG(_header.version == BinVecs::Version,
+                    "Unsupported BinVecs version");
+    VR_REQUIRED_MSG(_header.dtype == BinVecs::DTypeOf<T>::value,
+                    "Element type does not match \"" + _filename + "\"");
+    // compare the point count with what fits before multiplying, so a
+    // forged count cannot wrap payloadSize() around
+    const size_t rowBytes = size_t(_header.dim) * sizeof(T);
+    VR_REQUIRED_MSG(_header.payloadOffset <= _mapped.size() &&
+                        (rowBytes == 0 ||
+                         _header.n <= (_mapped.size() - _header.payloadOffset) /
+                                          rowBytes),
+                    "\"" + _filename + "\" is truncated");
+  }
+  // noncopyable
+  BinVecsReader(const BinVecsReader &) = delete;
+  BinVecsReader &operator=(const BinVecsReader &) = delete;
+
+  // get  data dimension
+  unsigned pointDimension() const { return _header.dim; }
+  // total number of points
+  size_t numPoints() const { return _header.n; }
+  // payload size in bytes
+  size_t payloadSize() const { return _header.n * _header.dim * sizeof(T); }
+  const BinVecs::Header &header() const { return _header; }
+
+  // first coordinate of the first point
+  const T *data() const {
+    return reinterpret_cast<const T *>(_mapped.data() + _header.payloadOffset);
+  }
+
+  // zero-copy view of the a-th point (including) until b-th point (not
+  // including)
+  VecsView<T> view(size_t a, size_t b,
+                   MappedFile::Advice advice = MappedFile::Sequential) {
+    VR_REQUIRED(b > a);
+    if (a >= numPoints())
+      return {};
+    if (b > numPoints())
+      b = numPoints();
+    size_t rowBytes = _header.dim * sizeof(T);
+    _mapped.advise(advice, _header.payloadOffset + a * rowBytes,
+                   (b - a) * rowBytes);
+    return VecsView<T>(data() + a * _header.dim, b - a, _header.dim,
+                       _header.dim);
+  }
+
+  // zero-copy view of all points
+  VecsView<T> view(MappedFile::Advice advice = MappedFile::Sequential) {
+    if (numPoints() == 0)
+      return {};
+    return view(0, numPoints(), advice);
+  }
+
+  // copy of the a-th point (including) until b-th point (not including)
+  std::vector<T> read(size_t a, size_t b) {
+    auto v = view(a, b);
+    std::vector<T> data(v.numPoints() * _header.dim);
+    if (!data.empty())
+      std::memcpy(data.data(), v.data(), data.size() * sizeof(T));
+    return data;
+  }
+
+  // recompute the payload checksum and compare it with the header
+  bool verify() const {
+    BinVecs::Checksum sum;
+    sum.update(data(), payloadSize());
+    return sum.digest() == _header.checksum;
+  }
+
+private:
+  std::string _filename;
+  MappedFile _mapped;
+  BinVecs::Header _header;
+};
+
+#endif // _BIN_VECS_HPP_
@@ -0,0 +1,93 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include "BinVecs.hpp"
+#include "Exception.h"
+
+using namespace npp;
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+const char *FVF = "./sample-data/gist_query.fvecs";
+
+template <typename T> void checkCache(const char *input) {
+  auto output = BinVecs::cacheName(input);
+  NPP_ASSERT(BinVecs::convert(input, output) > 0);
+
+  VecsReader<T> reader(input);
+  auto all = reader.read();
+  BinVecsReader<T> cache(output.c_str());
+  NPP_ASSERT(cache.numPoints() == reader.numPoints());
+  NPP_ASSERT(cache.pointDimension() == reader.pointDimension());
+  NPP_ASSERT(cache.verify());
+  NPP_ASSERT(reinterpret_cast<uintptr_t>(cache.data()) %
+                 BinVecs::DefaultAlignment ==
+             0);
+
+  auto view = cache.view();
+  NPP_ASSERT(std::equal(view.data(),
+                        view.data() + view.numPoints() * view.stride(),
+                        all.begin()));
+  NPP_ASSERT(cache.read(5, 7) == reader.read(5, 7));
+  NPP_ASSERT(cache.view(cache.numPoints(), cache.numPoints() + 1).empty());
+
+  bool thrown = false;
+  try {
+    BinVecsReader<int32_t> wrong(output.c_str()); // wrong element type
+  } catch (const VecsReaderException &) {
+    thrown = true;
+  }
+  NPP_ASSERT(thrown);
+
+  // a flipped payload byte fails verification
+  {
+    FILE *fp = fopen(output.c_str(), "r+b");
+    fseek(fp, BinVecs::DefaultAlignment + 100, SEEK_SET);
+    int c = fgetc(fp);
+    fseek(fp, BinVecs::DefaultAlignment + 100, SEEK_SET);
+    fputc(c ^ 1, fp);
+    fclose(fp);
+    BinVecsReader<T> corrupted(output.c_str());
+    NPP_ASSERT(!corrupted.verify());
+  }
+
+  // a point count whose payload size wraps around 64 bits is rejected
+  {
+    uint64_t rowBytes = reader.pointDimension() * sizeof(T);
+    uint64_t n = UINT64_MAX / rowBytes + 1;
+    FILE *fp = fopen(output.c_str(), "r+b");
+    fseek(fp, offsetof(BinVecs::Header, n), SEEK_SET);
+    fwrite(&n, sizeof(n), 1, fp);
+    fclose(fp);
+    thrown = false;
+    try {
+      BinVecsReader<T> forged(output.c_str());
+    } catch (const VecsReaderException &) {
+      thrown = true;
+    }
+    NPP_ASSERT(thrown);
+  }
+  remove(output.c_str());
+}
+
+int main() {
+  try {
+    NPP_ASSERT(BinVecs::cacheName("a/b.fvecs") == "a/b.fbin");
+    NPP_ASSERT(BinVecs::cacheName("a/b.bvecs") == "a/b.u8bin");
+    checkCache<uint8_t>(BVF);
+    checkCache<float>(FVF);
+
+    // the checksum does not depend on how the input is split
+    std::vector<char> bytes(1000);
+    for (size_t i = 0; i < bytes.size(); ++i)
+      bytes[i] = static_cast<char>(i * 7);
+    BinVecs::Checksum whole, pieces;
+    whole.update(bytes.data(), bytes.size());
+    for (size_t i = 0, step = 1; i < bytes.size(); i += step, step += 3)
+      pieces.update(&bytes[i], std::min(step, bytes.size() - i));
+    NPP_ASSERT(whole.digest() == pieces.digest());
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
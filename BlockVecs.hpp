@@ -0,0 +1,808 @@
+#ifndef _BLOCK_VECS_HPP_
+#define _BLOCK_VECS_HPP_
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BLOCK_VECS_X86 1
+#include <immintrin.h>
+#endif
+
+#include "BinVecs.hpp"
+#include "ParallelUtils.hpp"
+#include "PosixFile.hpp"
+#include "VecsReader.h"
+
+// Block-compressed vecs file (.fblk/.u8blk/.iblk): one 64-byte header, the
+// points in blocks of <blockPoints> rows that are compressed independently,
+// and an index of block offsets at the end. Blocks are compressed with a
+// byte-plane shuffle (byte k of every element together, so e.g. the float
+// exponents end up next to each other). A plane of a few bits per byte gets
+// a canonical Huffman code, any other plane is bit packed in groups of 4
+// bytes or stored raw, so that decoding keeps up with the disk.
+namespace BlockVecs {
+
+// raw bytes of a block when compress() picks the block size
+constexpr size_t DefaultBlockBytes = 256u << 10;
+// blocks per thread at least, so that scans decode in parallel
+constexpr size_t MinBlocksPerThread = 4;
+constexpr char Magic[8] = {'V', 'E', 'C', 'S', 'B', 'L', 'K', '\0'};
+// version 2 added Packed planes, version 1 files are still read
+constexpr uint32_t Version = 2;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t dtype;       // see BinVecs::DType
+  uint64_t n;           // number of points
+  uint32_t dim;         // data dimension
+  uint32_t blockPoints; // points per block, the last one may have fewer
+  uint64_t numBlocks;
+  uint64_t indexOffset; // numBlocks + 1 uint64_t block offsets
+  char reserved[16];
+};
+static_assert(sizeof(Header) == 64, "header must be 64 bytes");
+
+// byte-plane codec of one block
+namespace Codec {
+
+enum PlaneMode : uint8_t { Raw = 0, Huffman = 1, Constant = 2, Packed = 3 };
+// longest code, i.e., decode table size is 1 << MaxBits
+constexpr unsigned MaxBits = 11;
+// a plane is coded only if that saves 1 / MinSaving of it, as raw planes
+// decode with a memcpy, e.g., the near random low mantissa bytes of floats
+constexpr size_t MinSaving = 16;
+
+// Huffman code lengths of the 256 byte values limited to MaxBits; the
+// frequencies are halved until the tree is shallow enough
+inline void codeLengths(const uint64_t freq[256], uint8_t len[256]) {
+  std::vector<uint64_t> f(freq, freq + 256);
+  for (;;) {
+    using Item = std::pair<uint64_t, int>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+    std::vector<int> parent(512, -1);
+    for (int s = 0; s < 256; ++s)
+      if (f[s] > 0)
+        heap.push({f[s], s});
+    int next = 256;
+    while (heap.size() > 1) {
+      auto a = heap.top();
+      heap.pop();
+      auto b = heap.top();
+      heap.pop();
+      parent[a.second] = parent[b.second] = next;
+      heap.push({a.first + b.first, next++});
+    }
+    unsigned longest = 0;
+    for (int s = 0; s < 256; ++s) {
+      unsigned depth = 0;
+      for (int p = parent[s]; p >= 0; p = parent[p])
+        ++depth;
+      len[s] = static_cast<uint8_t>(depth);
+      longest = std::max(longest, depth);
+    }
+    if (longest <= MaxBits)
+      return;
+    for (auto &v : f)
+      if (v > 0)
+        v = (v + 1) / 2;
+  }
+}
+
+// canonical codes of <len>, bit reversed to be written LSB first
+inline void canonicalCodes(const uint8_t len[256], uint16_t code[256]) {
+  unsigned count[MaxBits + 1] = {0}, next[MaxBits + 2] = {0};
+  for (int s = 0; s < 256; ++s)
+    ++count[len[s]];
+  count[0] = 0;
+  for (unsigned l = 1; l <= MaxBits; ++l)
+    next[l + 1] = (next[l] + count[l]) << 1;
+  for (int s = 0; s < 256; ++s) {
+    if (len[s] == 0)
+      continue;
+    unsigned c = next[len[s]]++, r = 0;
+    for (unsigned i = 0; i < len[s]; ++i, c >>= 1)
+      r = (r << 1) | (c & 1);
+    code[s] = static_cast<uint16_t>(r);
+  }
+}
+
+// a Huffman coded plane is split into this many segments with separate
+// bitstreams, decoded interleaved to hide the latency of each table lookup
+constexpr unsigned Streams = 4;
+// mode, code lengths (two per byte) and stream sizes
+constexpr size_t HuffmanHead = 1 + 128 + 4 * Streams;
+// only planes of at most this many bits per byte are Huffman coded; they
+// decode several codes per table lookup, while planes of longer codes decode
+// at about one byte per ns, slower than a fast disk reads them
+constexpr size_t MultiBits = 4;
+
+// [first, last) bytes of the <s>-th segment of a plane of <n> bytes
+inline std::pair<size_t, size_t> segment(size_t n, unsigned s) {
+  size_t q = (n + Streams - 1) / Streams;
+  return {std::min(n, s * q), std::min(n, (s + 1) * q)};
+}
+
+// A Packed plane stores the bytes in groups of PackGroup with the bit width
+// of the largest one, e.g., 4 bits for a group of values below 16. The
+// widths of two groups share a byte, low nibble first, and are followed by
+// the bits of all groups, LSB first; a partial last group is padded with
+// zeros.
+constexpr size_t PackGroup = 4;
+
+inline unsigned bitWidth(unsigned v) {
+  unsigned b = 0;
+  for (; v != 0; v >>= 1)
+    ++b;
+  return b;
+}
+
+// bytes of the widths and of the bits of <n> bytes
+inline std::pair<size_t, size_t> packedSize(const uint8_t *src, size_t n) {
+  size_t groups = (n + PackGroup - 1) / PackGroup, bits = 0;
+  for (size_t g = 0; g < groups; ++g) {
+    unsigned m = 0;
+    for (size_t i = g * PackGroup; i < std::min(n, (g + 1) * PackGroup); ++i)
+      m |= src[i];
+    bits += PackGroup * bitWidth(m);
+  }
+  return {(groups + 1) / 2, (bits + 7) / 8};
+}
+
+// write the Packed encoding of <n> bytes, packedSize() bytes, to <p>
+inline void encodePacked(const uint8_t *src, size_t n, uint8_t *p) {
+  size_t groups = (n + PackGroup - 1) / PackGroup;
+  uint8_t *widths = p, *bits = p + (groups + 1) / 2;
+  std::memset(widths, 0, (groups + 1) / 2);
+  uint64_t acc = 0;
+  unsigned nbits = 0;
+  for (size_t g = 0; g < groups; ++g) {
+    uint8_t v[PackGroup] = {0};
+    unsigned m = 0;
+    for (size_t i = 0; i < PackGroup && g * PackGroup + i < n; ++i)
+      m |= v[i] = src[g * PackGroup + i];
+    unsigned b = bitWidth(m);
+    widths[g / 2] |= static_cast<uint8_t>(b << (4 * (g % 2)));
+    for (size_t i = 0; i < PackGroup; ++i, nbits += b)
+      acc |= static_cast<uint64_t>(v[i]) << nbits;
+    for (; nbits >= 8; nbits -= 8, acc >>= 8)
+      *bits++ = static_cast<uint8_t>(acc);
+  }
+  if (nbits > 0)
+    *bits = static_cast<uint8_t>(acc);
+}
+
+// <b> bits at bit <pos> of bits[0, len)
+inline uint8_t packedValue(const uint8_t *bits, size_t len, size_t pos,
+                           unsigned b) {
+  size_t i = pos / 8;
+  unsigned x = bits[i] | (i + 1 < len ? bits[i + 1] << 8 : 0);
+  return static_cast<uint8_t>((x >> (pos % 8)) & ((1u << b) - 1));
+}
+
+// decode the 8 values of each widths byte from <u> to <last> into <dst>,
+// reading bits[0, len) from bit <pos>; <u> and <pos> end after them
+inline void unpackScalar(const uint8_t *widths, size_t &u, size_t last,
+                         const uint8_t *bits, size_t len, size_t &pos,
+                         uint8_t *dst) {
+  for (; u < last; ++u)
+    for (size_t i = 0; i < 2 * PackGroup; ++i) {
+      unsigned b = (widths[u] >> (i < PackGroup ? 0 : 4)) & 0xf;
+      dst[u * 2 * PackGroup + i] = packedValue(bits, len, pos, b);
+      pos += b;
+    }
+}
+
+#ifdef BLOCK_VECS_X86
+// the 8 values of a widths byte come from one 16-byte load: a shuffle puts
+// the two bytes holding each value in a 16-bit lane, a multiply moves its
+// bits up to bit 8, and a shift and a mask leave the value. The tables are
+// per widths byte and per start bit in the first byte, 0 or 4.
+struct UnpackTables {
+  __m128i shuffle[512], scale[512], mask[512];
+
+  UnpackTables() {
+    for (unsigned w = 0; w < 256; ++w)
+      for (unsigned start = 0; start < 8; start += 4) {
+        alignas(16) uint8_t sh[16];
+        alignas(16) uint16_t sc[8], mk[8];
+        unsigned pos = start;
+        for (unsigned i = 0; i < 8; ++i) {
+          unsigned b = std::min(8u, (w >> (i < 4 ? 0 : 4)) & 0xf);
+          sh[2 * i] = static_cast<uint8_t>(pos / 8);
+          sh[2 * i + 1] = static_cast<uint8_t>(pos / 8 + 1);
+          sc[i] = static_cast<uint16_t>(1u << (8 - pos % 8));
+          mk[i] = static_cast<uint16_t>((1u << b) - 1);
+          pos += b;
+        }
+        unsigned k = 2 * w + start / 4;
+        shuffle[k] = _mm_load_si128(reinterpret_cast<const __m128i *>(sh));
+        scale[k] = _mm_load_si128(reinterpret_cast<const __m128i *>(sc));
+        mask[k] = _mm_load_si128(reinterpret_cast<const __m128i *>(mk));
+      }
+  }
+};
+
+// unpackScalar() while there are 16 bytes left to load
+__attribute__((target("ssse3"))) inline void
+unpackSSSE3(const uint8_t *widths, size_t &u, size_t last, const uint8_t *bits,
+            size_t len, size_t &pos, uint8_t *dst) {
+  static const UnpackTables t;
+  for (; u < last && pos / 8 + 16 <= len; ++u) {
+    unsigned w = widths[u], k = 2 * w + pos % 8 / 4;
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(bits + pos / 8));
+    v = _mm_shuffle_epi8(v, t.shuffle[k]);
+    v = _mm_srli_epi16(_mm_mullo_epi16(v, t.scale[k]), 8);
+    v = _mm_and_si128(v, t.mask[k]);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + u * 2 * PackGroup),
+                     _mm_packus_epi16(v, v));
+    pos += PackGroup * ((w & 0xf) + (w >> 4));
+  }
+}
+#endif
+
+// decode <n> bytes of a Packed plane from src[0, len) into <dst>; returns the
+// number of bytes consumed
+inline size_t decodePacked(const uint8_t *src, size_t len, uint8_t *dst,
+                           size_t n) {
+  size_t groups = (n + PackGroup - 1) / PackGroup, head = (groups + 1) / 2;
+  VR_REQUIRED_MSG(len >= head, "Corrupt block");
+  // a branch free pass over the widths, the nibble after an odd last group
+  // is 0
+  size_t bits = 0;
+  unsigned bad = 0;
+  for (size_t i = 0; i < head; ++i) {
+    unsigned lo = src[i] & 0xf, hi = src[i] >> 4;
+    bits += lo + hi;
+    bad |= (lo > 8) | (hi > 8);
+  }
+  VR_REQUIRED_MSG(bad == 0, "Corrupt block");
+  size_t payload = (PackGroup * bits + 7) / 8;
+  VR_REQUIRED_MSG(len - head >= payload, "Corrupt block");
+
+  // whole widths bytes, i.e., 8 values, then the last values one by one
+  const uint8_t *widths = src, *in = src + head;
+  size_t u = 0, whole = n / (2 * PackGroup), pos = 0;
+#ifdef BLOCK_VECS_X86
+  static const bool ssse3 = __builtin_cpu_supports("ssse3");
+  if (ssse3)
+    unpackSSSE3(widths, u, whole, in, payload, pos, dst);
+#endif
+  unpackScalar(widths, u, whole, in, payload, pos, dst);
+  for (size_t i = whole * 2 * PackGroup; i < n; ++i) {
+    unsigned b = (widths[i / PackGroup / 2] >> (4 * (i / PackGroup % 2))) & 0xf;
+    dst[i] = packedValue(in, payload, pos, b);
+    pos += b;
+  }
+  return head + payload;
+}
+
+// append the encoding of <n> bytes to <out>
+inline void encodePlane(const uint8_t *src, size_t n, std::vector<char> &out) {
+  uint64_t freq[256] = {0};
+  for (size_t i = 0; i < n; ++i)
+    ++freq[src[i]];
+  if (n > 0 && freq[src[0]] == n) {
+    out.push_back(static_cast<char>(Constant));
+    out.push_back(static_cast<char>(src[0]));
+    return;
+  }
+
+  uint8_t len[256];
+  uint16_t code[256];
+  codeLengths(freq, len);
+  canonicalCodes(len, code);
+  uint32_t sizes[Streams];
+  size_t payload = 0;
+  for (unsigned s = 0; s < Streams; ++s) {
+    auto seg = segment(n, s);
+    uint64_t bits = 0;
+    for (size_t i = seg.first; i < seg.second; ++i)
+      bits += len[src[i]];
+    sizes[s] = static_cast<uint32_t>((bits + 7) / 8);
+    payload += sizes[s];
+  }
+  // the smaller of a Huffman code of a few bits per byte and bit packing,
+  // or raw if neither saves enough
+  auto packed = packedSize(src, n);
+  size_t packedBytes = packed.first + packed.second;
+  size_t best = n;
+  if (payload * 8 <= n * MultiBits)
+    best = std::min(best, HuffmanHead - 1 + payload);
+  best = std::min(best, packedBytes);
+  if (n == 0 || best + n / MinSaving >= n) {
+    out.push_back(static_cast<char>(Raw));
+    out.insert(out.end(), src, src + n);
+    return;
+  }
+  if (best == packedBytes) {
+    size_t pos = out.size();
+    out.resize(pos + 1 + packedBytes);
+    out[pos] = static_cast<char>(Packed);
+    encodePacked(src, n, reinterpret_cast<uint8_t *>(out.data() + pos + 1));
+    return;
+  }
+
+  size_t pos = out.size();
+  out.resize(pos + HuffmanHead + payload);
+  char *p = out.data() + pos;
+  *p++ = static_cast<char>(Huffman);
+  for (int s = 0; s < 256; s += 2) // lengths are at most 11, two per byte
+    *p++ = static_cast<char>(len[s] | (len[s + 1] << 4));
+  std::memcpy(p, sizes, sizeof(sizes));
+  p += sizeof(sizes);
+  for (unsigned s = 0; s < Streams; ++s) {
+    auto seg = segment(n, s);
+    uint64_t acc = 0;
+    unsigned nbits = 0;
+    for (size_t i = seg.first; i < seg.second; ++i) {
+      acc |= static_cast<uint64_t>(code[src[i]]) << nbits;
+      nbits += len[src[i]];
+      while (nbits >= 8) {
+        *p++ = static_cast<char>(acc & 0xff);
+        acc >>= 8;
+        nbits -= 8;
+      }
+    }
+    if (nbits > 0)
+      *p++ = static_cast<char>(acc & 0xff);
+  }
+}
+
+// LSB-first reader of one bitstream
+struct BitReader {
+  const uint8_t *in;
+  const uint8_t *end;
+  uint64_t acc;
+  unsigned nbits;
+
+  // at least 56 bits with one load, needs 8 bytes left
+  void refillFast() {
+    uint64_t w;
+    std::memcpy(&w, in, 8);
+    acc |= w << nbits;
+    in += (63 - nbits) >> 3;
+    nbits |= 56;
+  }
+  void refill() {
+    while (nbits <= 56 && in < end) {
+      acc |= static_cast<uint64_t>(*in++) << nbits;
+      nbits += 8;
+    }
+  }
+  // next symbol from a table of (symbol << 4 | code length)
+  uint8_t decode(const uint16_t *table) {
+    uint16_t e = table[acc & ((1u << MaxBits) - 1)];
+    acc >>= e & 0xf;
+    nbits -= e & 0xf;
+    return static_cast<uint8_t>(e >> 4);
+  }
+  // next one to three symbols from a table of (third << 24 | second << 16 |
+  // first << 8 | count << 4 | length of the codes); all three bytes are
+  // stored, the returned position is after the decoded ones
+  uint8_t *decodeMulti(const uint32_t *multi, uint8_t *out) {
+    uint32_t e = multi[acc & ((1u << MaxBits) - 1)];
+    out[0] = static_cast<uint8_t>(e >> 8);
+    out[1] = static_cast<uint8_t>(e >> 16);
+    out[2] = static_cast<uint8_t>(e >> 24);
+    acc >>= e & 0xf;
+    nbits -= e & 0xf;
+    return out + ((e >> 4) & 0xf);
+  }
+};
+
+// decode <n> bytes from src[0, len) into <dst>; returns the number of bytes
+// consumed
+inline size_t decodePlane(const char *src, size_t len, uint8_t *dst,
+                          size_t n) {
+  VR_REQUIRED_MSG(len >= 1, "Corrupt block");
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(src);
+  switch (p[0]) {
+  case Constant:
+    VR_REQUIRED_MSG(len >= 2, "Corrupt block");
+    std::memset(dst, p[1], n);
+    return 2;
+  case Raw:
+    VR_REQUIRED_MSG(len >= 1 + n, "Corrupt block");
+    std::memcpy(dst, p + 1, n);
+    return 1 + n;
+  case Packed:
+    return 1 + decodePacked(p + 1, len - 1, dst, n);
+  case Huffman:
+    break;
+  default:
+    VR_REQUIRED_MSG(false, "Corrupt block");
+  }
+
+  VR_REQUIRED_MSG(len >= HuffmanHead, "Corrupt block");
+  uint8_t lens[256];
+  for (int s = 0; s < 256; s += 2) {
+    lens[s] = p[1 + s / 2] & 0xf;
+    lens[s + 1] = p[1 + s / 2] >> 4;
+    VR_REQUIRED_MSG(lens[s] <= MaxBits && lens[s + 1] <= MaxBits,
+                    "Corrupt block");
+  }
+  uint32_t sizes[Streams];
+  std::memcpy(sizes, p + 1 + 128, sizeof(sizes));
+  size_t payload = 0;
+  for (auto sz : sizes)
+    payload += sz;
+  VR_REQUIRED_MSG(len - HuffmanHead >= payload, "Corrupt block");
+
+  // every MaxBits-bit pattern maps to (symbol << 4 | code length); a code
+  // that does not fill the table exactly is corrupt
+  uint16_t codes[256];
+  canonicalCodes(lens, codes);
+  size_t kraft = 0;
+  for (int s = 0; s < 256; ++s)
+    if (lens[s] > 0)
+      kraft += size_t(1) << (MaxBits - lens[s]);
+  VR_REQUIRED_MSG(kraft == (1u << MaxBits), "Corrupt block");
+  uint16_t table[1u << MaxBits];
+  for (int s = 0; s < 256; ++s)
+    if (lens[s] > 0)
+      for (unsigned i = codes[s]; i < (1u << MaxBits); i += 1u << lens[s])
+        table[i] = static_cast<uint16_t>((s << 4) | lens[s]);
+
+  BitReader br[Streams];
+  uint8_t *out[Streams], *last[Streams];
+  const uint8_t *in = p + HuffmanHead;
+  for (unsigned s = 0; s < Streams; ++s) {
+    br[s] = {in, in + sizes[s], 0, 0};
+    in += sizes[s];
+    out[s] = dst + segment(n, s).first;
+    last[s] = dst + segment(n, s).second;
+  }
+  // all streams in lockstep while every one has 8 bytes and <room> symbols
+  // left, 5 lookups take at most 55 bits
+  auto roomy = [&](ptrdiff_t room) {
+    for (unsigned s = 0; s < Streams; ++s)
+      if (br[s].end - br[s].in < 8 || last[s] - out[s] < room)
+        return false;
+    return true;
+  };
+  if (payload * 8 <= n * MultiBits) {
+    // up to three codes that fit in MaxBits bits together are decoded with
+    // one lookup, which saves most lookups of skewed planes, e.g., float
+    // exponents
+    uint32_t multi[1u << MaxBits];
+    for (unsigned i = 0; i < (1u << MaxBits); ++i) {
+      uint32_t e = 0, bits = 0, count = 0;
+      while (count < 3) {
+        uint32_t t = table[i >> bits];
+        if (bits + (t & 0xf) > MaxBits)
+          break;
+        e |= (t >> 4) << (8 + 8 * count);
+        bits += t & 0xf;
+        ++count;
+      }
+      multi[i] = e | (count << 4) | bits;
+    }
+    while (roomy(15)) {
+      for (auto &r : br)
+        r.refillFast();
+      for (int k = 0; k < 5; ++k)
+        for (unsigned s = 0; s < Streams; ++s)
+          out[s] = br[s].decodeMulti(multi, out[s]);
+    }
+  } else { // longer codes, only in version 1 files
+    while (roomy(5)) {
+      for (auto &r : br)
+        r.refillFast();
+      for (int k = 0; k < 5; ++k)
+        for (unsigned s = 0; s < Streams; ++s)
+          out[s][k] = br[s].decode(table);
+      for (auto &o : out)
+        o += 5;
+    }
+  }
+  for (unsigned s = 0; s < Streams; ++s) {
+    while (out[s] < last[s]) {
+      br[s].refill();
+      VR_REQUIRED_MSG((table[br[s].acc & ((1u << MaxBits) - 1)] & 0xfu) <=
+                          br[s].nbits,
+                      "Corrupt block");
+      *out[s]++ = br[s].decode(table);
+    }
+  }
+  return HuffmanHead + payload;
+}
+
+// append the encoding of <n> elements of <elemSize> bytes to <out>
+inline void encodeBlock(const void *src, size_t n, size_t elemSize,
+                        std::vector<char> &out) {
+  const uint8_t *s = static_cast<const uint8_t *>(src);
+  if (elemSize == 1) {
+    encodePlane(s, n, out);
+    return;
+  }
+  std::vector<uint8_t> plane(n);
+  for (size_t k = 0; k < elemSize; ++k) {
+    for (size_t i = 0; i < n; ++i)
+      plane[i] = s[i * elemSize + k];
+    encodePlane(plane.data(), n, out);
+  }
+}
+
+// decode <n> elements of <elemSize> bytes from src[0, len) into <dst>, with
+// <planes> as scratch space reused across blocks
+inline void decodeBlock(const char *src, size_t len, void *dst, size_t n,
+                        size_t elemSize, std::vector<uint8_t> &planes) {
+  uint8_t *d = static_cast<uint8_t *>(dst);
+  if (elemSize == 1) {
+    decodePlane(src, len, d, n);
+    return;
+  }
+  if (planes.size() < n * elemSize)
+    planes.resize(n * elemSize);
+  size_t used = 0;
+  for (size_t k = 0; k < elemSize; ++k)
+    used += decodePlane(src + used, len - used, planes.data() + k * n, n);
+  if (elemSize == 4) { // gather the 4 planes with sequential writes
+    const uint8_t *p0 = planes.data(), *p1 = p0 + n, *p2 = p1 + n,
+                  *p3 = p2 + n;
+    for (size_t i = 0; i < n; ++i) {
+      d[4 * i] = p0[i];
+      d[4 * i + 1] = p1[i];
+      d[4 * i + 2] = p2[i];
+      d[4 * i + 3] = p3[i];
+    }
+    return;
+  }
+  for (size_t i = 0; i < n; ++i)
+    for (size_t k = 0; k < elemSize; ++k)
+      d[i * elemSize + k] = planes[k * n + i];
+}
+
+inline void decodeBlock(const char *src, size_t len, void *dst, size_t n,
+                        size_t elemSize) {
+  std::vector<uint8_t> planes;
+  decodeBlock(src, len, dst, n, elemSize, planes);
+}
+} // namespace Codec
+
+// block-compressed file name for a vecs file, e.g., a/b.fvecs -> a/b.fblk
+inline std::string blockName(const std::string &input) {
+  auto parts = FilenameUtils::pathextSplit(input);
+  auto ext = StringUtils::toLower(parts.second);
+  if (ext == ".fvecs")
+    return parts.first + ".fblk";
+  if (ext == ".bvecs")
+    return parts.first + ".u8blk";
+  if (ext == ".ivecs")
+    return parts.first + ".iblk";
+  throw VecsReaderException(__FILE__, __LINE__,
+                            "Unsupported vecs file \"" + input + "\"");
+}
+
+// points per block of <n> points of <rowBytes> bytes read by <numThreads>
+// threads: about DefaultBlockBytes, fewer if that would leave less than
+// MinBlocksPerThread blocks per thread
+inline uint32_t defaultBlockPoints(size_t n, size_t rowBytes,
+                                   unsigned numThreads) {
+  size_t bySize = DefaultBlockBytes / std::max<size_t>(1, rowBytes);
+  size_t blocks = MinBlocksPerThread * std::max(1u, numThreads);
+  size_t byThreads = (n + blocks - 1) / blocks;
+  return static_cast<uint32_t>(
+      std::max<size_t>(1, std::min<size_t>({bySize, byThreads, UINT32_MAX})));
+}
+
+// compress the .fvecs/.bvecs/.ivecs file <input> into <output>, a batch of
+// blocks at a time with one block per thread; <blockPoints> is 0 to pick it
+// with defaultBlockPoints(); returns the number of points written
+inline size_t compress(const std::string &input, const std::string &output,
+                       uint32_t blockPoints = 0, unsigned numThreads = 0) {
+  if (numThreads == 0)
+    numThreads = ParallelUtils::defaultThreads();
+  return visitVecsReader<float>(input, [&](auto &reader) {
+    using Elem = typename std::decay_t<decltype(reader)>::ElemType;
+    if (blockPoints == 0)
+      blockPoints =
+          defaultBlockPoints(reader.numPoints(),
+                             size_t(reader.pointDimension()) * sizeof(Elem),
+                             numThreads);
+    FILE *fp = fopen(output.c_str(), "wb");
+    VR_REQUIRED_MSG(fp != nullptr, "Opening \"" + output + "\" failed!");
+    std::unique_ptr<FILE, decltype(&fclose)> guard(fp, &fclose);
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, Magic, sizeof(Magic));
+    h.version = Version;
+    h.dtype = BinVecs::DTypeOf<Elem>::value;
+    h.n = reader.numPoints();
+    h.dim = reader.pointDimension();
+    h.blockPoints = blockPoints;
+    h.numBlocks = (h.n + blockPoints - 1) / blockPoints;
+    VR_REQUIRED(fwrite(&h, sizeof(h), 1, fp) == 1);
+
+    // batches of about 64MB, at least one block per thread
+    const size_t blockElems = size_t(blockPoints) * h.dim;
+    const size_t blockBytes = std::max<size_t>(1, blockElems * sizeof(Elem));
+    const size_t batch = std::max<size_t>(numThreads, (64u << 20) / blockBytes);
+    std::vector<Elem> raw(batch * blockElems);
+    std::vector<std::vector<char>> packed(batch);
+    std::vector<uint64_t> index = {sizeof(Header)};
+    size_t written = 0;
+    while (written < h.n) {
+      size_t m = reader.readInto(
+          raw.data(), std::min<size_t>(batch * blockPoints, h.n - written));
+      VR_REQUIRED_MSG(m > 0, "Bad vecs file!");
+      size_t blocks = (m + blockPoints - 1) / blockPoints;
+      ParallelUtils::parallelFor(
+          blocks, numThreads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t b = begin; b < end; ++b) {
+              size_t rows = std::min<size_t>(blockPoints, m - b * blockPoints);
+              packed[b].clear();
+              Codec::encodeBlock(raw.data() + b * blockElems, rows * h.dim,
+                                 sizeof(Elem), packed[b]);
+            }
+          });
+      for (size_t b = 0; b < blocks; ++b) {
+        VR_REQUIRED(fwrite(packed[b].data(), 1, packed[b].size(), fp) ==
+                    packed[b].size());
+        index.push_back(index.back() + packed[b].size());
+      }
+      written += m;
+    }
+
+    h.indexOffset = index.back();
+    VR_REQUIRED(fwrite(index.data(), sizeof(uint64_t), index.size(), fp) ==
+                index.size());
+    VR_REQUIRED(fseek(fp, 0, SEEK_SET) == 0);
+    VR_REQUIRED(fwrite(&h, sizeof(h), 1, fp) == 1);
+    VR_REQUIRED(fflush(fp) == 0);
+    return written;
+  });
+}
+} // namespace BlockVecs
+
+// reader of a block-compressed vecs file holding elements of type T. Reads
+// fetch the compressed blocks covering the range with pread and decompress
+// them on <numThreads> threads; every thread asks the kernel to read its next
+// block ahead, so that the disk reads it while the thread decodes.
+template <typename T> class BlockVecsReader {
+public:
+  BlockVecsReader(const char *filename, unsigned numThreads = 0)
+      : _file(filename), _threads(numThreads), _cur_pos(0) {
+    VR_REQUIRED_MSG(_file.size() >= sizeof(_header),
+                    "\"" + _file.filename() + "\" is too small");
+    _file.pread(&_header, sizeof(_header), 0);
+    VR_REQUIRED_MSG(std::memcmp(_header.magic, BlockVecs::Magic,
+                                sizeof(BlockVecs::Magic)) == 0,
+                    "\"" + _file.filename() + "\" is not a BlockVecs file");
+    VR_REQUIRED_MSG(_header.version >= 1 &&
+                        _header.version <= BlockVecs::Version,
+                    "Unsupported BlockVecs version");
+    VR_REQUIRED_MSG(_header.dtype == BinVecs::DTypeOf<T>::value,
+                    "Element type does not match \"" + _file.filename() +
+                        "\"");
+    VR_REQUIRED_MSG(_header.blockPoints > 0 &&
+                        _header.numBlocks ==
+                            (_header.n + _header.blockPoints - 1) /
+                                _header.blockPoints,
+                    "Bad block layout");
+    size_t indexBytes = (_header.numBlocks + 1) * sizeof(uint64_t);
+    VR_REQUIRED_MSG(_header.indexOffset + indexBytes <= _file.size(),
+                    "\"" + _file.filename() + "\" is truncated");
+    _index.resize(_header.numBlocks + 1);
+    _file.pread(_index.data(), indexBytes, _header.indexOffset);
+    for (size_t b = 0; b < _header.numBlocks; ++b)
+      VR_REQUIRED_MSG(_index[b] <= _index[b + 1], "Bad block index");
+    VR_REQUIRED_MSG(_index.back() <= _header.indexOffset, "Bad block index");
+  }
+  // noncopyable
+  BlockVecsReader(const BlockVecsReader &) = delete;
+  BlockVecsReader &operator=(const BlockVecsReader &) = delete;
+
+  // get  data dimension
+  unsigned pointDimension() const { return _header.dim; }
+  // total number of points
+  size_t numPoints() const { return _header.n; }
+  size_t blockPoints() const { return _header.blockPoints; }
+  size_t numBlocks() const { return _header.numBlocks; }
+  // bytes of compressed blocks, i.e., without header and index
+  size_t compressedSize() const { return _index.back() - _index.front(); }
+  // bytes of the uncompressed points
+  size_t rawSize() const { return _header.n * _header.dim * sizeof(T); }
+  const BlockVecs::Header &header() const { return _header; }
+
+  // read from a-th point (including) until b-th point (not including) into
+  // <dst>, which must be large enough for the points up to <b> (or the end of
+  // the file); returns the number of points read
+  size_t readInto(Span<T> dst, // destination
+                  size_t a,    // first (including)
+                  size_t b     // last (excluding)
+  ) {
+    VR_REQUIRED(b > a);
+    if (a >= numPoints())
+      return 0;
+    if (b > numPoints())
+      b = numPoints();
+
+    const size_t dim = _header.dim, bp = _header.blockPoints;
+    VR_REQUIRED_MSG(dst.size() >= (b - a) * dim, "Destination is too small");
+    const size_t first = a / bp, last = (b - 1) / bp + 1;
+    ParallelUtils::parallelFor(
+        last - first, _threads, [&](size_t begin, size_t end, unsigned) {
+          std::vector<char> packed;
+          std::vector<T> block;
+          std::vector<uint8_t> planes;
+          for (size_t k = first + begin; k < first + end; ++k) {
+            size_t lo = k * bp, hi = std::min(lo + bp, numPoints());
+            size_t len = _index[k + 1] - _index[k];
+            packed.resize(len);
+            VR_REQUIRED_MSG(_file.pread(packed.data(), len, _index[k]) == len,
+                            "\"" + _file.filename() + "\" is truncated");
+            if (k + 1 < first + end)
+              ::posix_fadvise(_file.fd(), _index[k + 1],
+                              _index[k + 2] - _index[k + 1],
+                              POSIX_FADV_WILLNEED);
+            size_t from = std::max(lo, a), to = std::min(hi, b);
+            T *out = dst.data() + (from - a) * dim;
+            if (from == lo && to == hi) { // whole block, decode in place
+              BlockVecs::Codec::decodeBlock(packed.data(), len, out,
+                                            (hi - lo) * dim, sizeof(T),
+                                            planes);
+            } else {
+              block.resize((hi - lo) * dim);
+              BlockVecs::Codec::decodeBlock(packed.data(), len, block.data(),
+                                            block.size(), sizeof(T), planes);
+              std::copy(block.begin() + (from - lo) * dim,
+                        block.begin() + (to - lo) * dim, out);
+            }
+          }
+        });
+    return b - a;
+  }
+
+  // read from a-th point (including) until b-th point (not including)
+  std::vector<T> read(size_t a, // first (including)
+                      size_t b  // last (excluding)
+  ) {
+    VR_REQUIRED(b > a);
+    if (a >= numPoints())
+      return {};
+    if (b > numPoints())
+      b = numPoints();
+    std::vector<T> data((b - a) * _header.dim);
+    readInto(Span<T>(data), a, b);
+    return data;
+  }
+
+  // read <n> points starting from current position
+  std::vector<T> read(size_t n) {
+    if (n > numPoints() - _cur_pos)
+      n = numPoints() - _cur_pos;
+    if (n == 0)
+      return {};
+    auto data = read(_cur_pos, _cur_pos + n);
+    _cur_pos += n;
+    return data;
+  }
+
+  // read all remaining points starting from current position
+  std::vector<T> read() { return read(numPoints() - _cur_pos); }
+
+  // seek to the begining of the file
+  void rewind() { _cur_pos = 0; }
+
+private:
+  PosixFile _file;
+  unsigned _threads;
+  BlockVecs::Header _header;
+  std::vector<uint64_t> _index;
+  size_t _cur_pos;
+};
+
+#endif // _BLOCK_VECS_HPP_
@@ -0,0 +1,185 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include "BlockVecs.hpp"
+#include "Exception.h"
+
+using namespace npp;
+using namespace BlockVecs;
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+const char *FVF = "./sample-data/gist_query.fvecs";
+
+void checkCodec(const std::vector<uint8_t> &data, size_t elemSize) {
+  std::vector<char> packed = {'x'}; // appends after existing bytes
+  Codec::encodeBlock(data.data(), data.size() / elemSize, elemSize, packed);
+  std::vector<uint8_t> back(data.size() + 1, 0xab);
+  Codec::decodeBlock(packed.data() + 1, packed.size() - 1, back.data(),
+                     data.size() / elemSize, elemSize);
+  NPP_ASSERT(std::equal(data.begin(), data.end(), back.begin()));
+  NPP_ASSERT(back[data.size()] == 0xab);
+}
+
+// <blockPoints> is 0 to let compress() pick it
+template <typename T>
+void checkFile(const char *input, uint32_t blockPoints, unsigned threads) {
+  auto output = blockName(input);
+  NPP_ASSERT(compress(input, output, blockPoints, threads) > 0);
+
+  VecsReader<T> reader(input);
+  auto all = reader.read();
+  BlockVecsReader<T> blk(output.c_str(), threads);
+  NPP_ASSERT(blk.numPoints() == reader.numPoints());
+  NPP_ASSERT(blk.pointDimension() == reader.pointDimension());
+  if (blockPoints == 0) { // a few blocks per thread, at most about 256KB
+    blockPoints = blk.blockPoints();
+    unsigned t = threads == 0 ? ParallelUtils::defaultThreads() : threads;
+    NPP_ASSERT(blk.numBlocks() >=
+               std::min<size_t>(blk.numPoints(), MinBlocksPerThread * t));
+    NPP_ASSERT(blockPoints * blk.pointDimension() * sizeof(T) <=
+                   DefaultBlockBytes ||
+               blockPoints == 1);
+  }
+  NPP_ASSERT(blk.blockPoints() == blockPoints);
+  NPP_ASSERT(blk.numBlocks() ==
+             (blk.numPoints() + blockPoints - 1) / blockPoints);
+  NPP_ASSERT(blk.compressedSize() < blk.rawSize());
+  std::cout << input << ": " << blk.compressedSize() << " / " << blk.rawSize()
+            << " bytes in " << blk.numBlocks() << " blocks" << std::endl;
+
+  NPP_ASSERT(blk.read(0, blk.numPoints()) == all);
+  const size_t dim = blk.pointDimension(), n = blk.numPoints();
+  std::mt19937 gen(2020);
+  std::uniform_int_distribution<size_t> dist(0, n - 1);
+  for (int r = 0; r < 50; ++r) {
+    size_t a = dist(gen), b = a + 1 + dist(gen) % (3 * blockPoints);
+    auto got = blk.read(a, b);
+    b = std::min(b, n);
+    NPP_ASSERT(std::equal(got.begin(), got.end(), all.begin() + a * dim) &&
+               got.size() == (b - a) * dim);
+  }
+  // block boundaries and the end of file
+  NPP_ASSERT(blk.read(blockPoints - 1, blockPoints + 1) ==
+             reader.read(blockPoints - 1, blockPoints + 1));
+  NPP_ASSERT(blk.read(n - 1, n + 100).size() == dim);
+  NPP_ASSERT(blk.read(n, n + 1).empty());
+
+  // streaming reads
+  auto first = blk.read(3);
+  NPP_ASSERT(std::equal(first.begin(), first.end(), all.begin()));
+  auto rest = blk.read();
+  NPP_ASSERT(std::equal(rest.begin(), rest.end(), all.begin() + 3 * dim) &&
+             rest.size() == all.size() - 3 * dim);
+  NPP_ASSERT(blk.read().empty());
+  blk.rewind();
+  NPP_ASSERT(blk.read(3) == first);
+
+  bool thrown = false;
+  try {
+    BlockVecsReader<int32_t> wrong(output.c_str()); // wrong element type
+  } catch (const VecsReaderException &) {
+    thrown = true;
+  }
+  NPP_ASSERT(thrown);
+
+  // damaged Huffman code lengths or Packed widths are detected when the
+  // block is decoded; raw and constant planes of the first block are skipped
+  {
+    FILE *fp = fopen(output.c_str(), "r+b");
+    size_t pos = sizeof(Header);
+    const size_t planeBytes = std::min<size_t>(blockPoints, n) * dim;
+    for (int mode; (mode = (fseek(fp, pos, SEEK_SET), fgetc(fp))) !=
+                       Codec::Huffman &&
+                   mode != Codec::Packed;)
+      pos += mode == Codec::Raw ? 1 + planeBytes : 2;
+    fseek(fp, pos + 1, SEEK_SET);
+    for (int i = 0; i < 128; ++i)
+      fputc(0xff, fp);
+    fclose(fp);
+    BlockVecsReader<T> corrupted(output.c_str(), threads);
+    thrown = false;
+    try {
+      corrupted.read(0, 1);
+    } catch (const VecsReaderException &) {
+      thrown = true;
+    }
+    NPP_ASSERT(thrown);
+  }
+  remove(output.c_str());
+}
+
+int main() {
+  try {
+    NPP_ASSERT(blockName("a/b.fvecs") == "a/b.fblk");
+    NPP_ASSERT(blockName("a/b.BVECS") == "a/b.u8blk");
+
+    // empty, constant, skewed and incompressible planes
+    std::mt19937 gen(2020);
+    std::vector<uint8_t> zeros(1000, 0), skewed(4000), small(4000),
+        noise(4000);
+    std::geometric_distribution<int> geo(0.3);
+    for (auto &v : skewed)
+      v = static_cast<uint8_t>(std::min(geo(gen), 255));
+    for (auto &v : small)
+      v = static_cast<uint8_t>(gen() % 64);
+    for (auto &v : noise)
+      v = static_cast<uint8_t>(gen());
+    checkCodec({}, 1);
+    checkCodec(zeros, 1);
+    checkCodec(zeros, 4);
+    checkCodec(skewed, 1);
+    checkCodec(skewed, 4);
+    checkCodec(noise, 1);
+    checkCodec(noise, 4);
+    std::vector<char> packed;
+    Codec::encodePlane(skewed.data(), skewed.size(), packed);
+    NPP_ASSERT(packed[0] == Codec::Huffman && packed.size() < skewed.size());
+    // about 6 bits per byte are bit packed rather than Huffman coded, then
+    // partial groups and the values after the last whole 16-byte load
+    packed.clear();
+    Codec::encodePlane(small.data(), small.size(), packed);
+    NPP_ASSERT(packed[0] == Codec::Packed &&
+               packed.size() <= 1 + small.size() / 8 + small.size() * 6 / 8);
+    for (size_t n = 1; n < 40; ++n)
+      checkCodec(std::vector<uint8_t>(small.begin(), small.begin() + n), 1);
+    { // the scalar unpacking alone, as SIMD decodes most of the plane
+      auto sizes = Codec::packedSize(small.data(), small.size());
+      std::vector<uint8_t> bits(sizes.first + sizes.second),
+          back(small.size());
+      Codec::encodePacked(small.data(), small.size(), bits.data());
+      size_t u = 0, pos = 0;
+      Codec::unpackScalar(bits.data(), u, small.size() / 8,
+                          bits.data() + sizes.first, sizes.second, pos,
+                          back.data());
+      NPP_ASSERT(back == small && pos == sizes.second * 8);
+    }
+    checkCodec(std::vector<uint8_t>(small.begin(), small.begin() + 3999), 1);
+    packed.clear();
+    Codec::encodePlane(noise.data(), noise.size(), packed);
+    NPP_ASSERT(packed[0] == Codec::Raw);
+    // 256 symbols with very skewed counts need length limiting
+    std::vector<uint8_t> fib;
+    for (int s = 0, c = 1; s < 256; ++s, c = std::min(c * 2, 1 << 20))
+      fib.insert(fib.end(), s < 20 ? c : 1, static_cast<uint8_t>(s));
+    checkCodec(fib, 1);
+
+    checkFile<uint8_t>(BVF, 1000, 1);
+    checkFile<uint8_t>(BVF, 777, 3);
+    checkFile<float>(FVF, 64, 2);
+    checkFile<float>(FVF, 1024, 0);
+    checkFile<uint8_t>(BVF, 0, 2);
+    checkFile<float>(FVF, 0, 1);
+
+    // near random planes stay raw, as decoding them would cost more than
+    // the few bytes coding saves
+    std::vector<uint8_t> almost(noise);
+    std::fill(almost.begin(), almost.begin() + almost.size() / 64, 0);
+    packed.clear();
+    Codec::encodePlane(almost.data(), almost.size(), packed);
+    NPP_ASSERT(packed[0] == Codec::Raw);
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,428 @@
+#ifndef _CONVERT_KERNELS_HPP_
+#define _CONVERT_KERNELS_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CK_X86 1
+#include <immintrin.h>
+#endif
+
+// widening conversions of uint8_t coordinates (e.g., .bvecs data) and
+// float <-> half precision conversions with SIMD kernels picked at runtime
+// from what the CPU supports
+namespace ConvertKernels {
+
+enum Isa { Scalar = 0, SSE41, AVX2, AVX512 };
+
+inline const char *isaName(Isa isa) {
+  switch (isa) {
+  case SSE41:
+    return "sse4.1";
+  case AVX2:
+    return "avx2";
+  case AVX512:
+    return "avx512";
+  default:
+    return "scalar";
+  }
+}
+
+// widest instruction set usable on this CPU
+inline Isa detectIsa() {
+#ifdef CK_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    return AVX512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"))
+    return AVX2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return SSE41;
+#endif
+  return Scalar;
+}
+
+using U8ToF32Fn = void (*)(const uint8_t *, float *, size_t);
+using U8ToU16Fn = void (*)(const uint8_t *, uint16_t *, size_t);
+// f16 results are IEEE 754 binary16 bit patterns
+using U8ToF16Fn = void (*)(const uint8_t *, uint16_t *, size_t);
+// f16/bf16 values are IEEE 754 binary16/bfloat16 bit patterns, rounded to
+// nearest even
+using F32ToHalfFn = void (*)(const float *, uint16_t *, size_t);
+using HalfToF32Fn = void (*)(const uint16_t *, float *, size_t);
+
+struct Kernels {
+  Isa isa;
+  U8ToF32Fn u8ToF32;
+  U8ToU16Fn u8ToU16;
+  U8ToF16Fn u8ToF16;
+  F32ToHalfFn f32ToF16;
+  HalfToF32Fn f16ToF32;
+  F32ToHalfFn f32ToBf16;
+  HalfToF32Fn bf16ToF32;
+};
+
+// binary16 bit pattern of an integer in [0, 255], which is always exact
+inline uint16_t u8ToHalf(uint8_t v) {
+  if (v == 0)
+    return 0;
+  unsigned e = 31 - __builtin_clz(v); // v = 1.m * 2^e
+  unsigned mant = (static_cast<unsigned>(v) << (10 - e)) & 0x3ffu;
+  return static_cast<uint16_t>(((e + 15) << 10) | mant);
+}
+
+inline uint32_t _floatBits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+inline float _bitsFloat(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// binary16 bit pattern of <f>, rounded to nearest even like F16C
+inline uint16_t floatToHalf(float f) {
+  uint32_t u = _floatBits(f);
+  uint32_t sign = (u >> 16) & 0x8000u;
+  u &= 0x7fffffffu;
+  if (u >= 0x47800000u) { // overflow to inf, or inf/NaN (kept quiet)
+    if (u > 0x7f800000u)
+      return static_cast<uint16_t>(sign | 0x7e00u | ((u >> 13) & 0x3ffu));
+    return static_cast<uint16_t>(sign | 0x7c00u);
+  }
+  if (u < 0x38800000u) { // subnormal or zero: let the FPU round at 2^-24
+    uint32_t r = _floatBits(_bitsFloat(u) + 0.5f) - 0x3f000000u;
+    return static_cast<uint16_t>(sign | r);
+  }
+  u += 0xc8000fffu + ((u >> 13) & 1u); // rebias exponent and round
+  return static_cast<uint16_t>(sign | (u >> 13));
+}
+
+inline float halfToFloat(uint16_t h) {
+  uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+  uint32_t e = (h >> 10) & 0x1fu, mant = h & 0x3ffu;
+  if (e == 0) // zero or subnormal, mant * 2^-24 is exact
+    return _bitsFloat(sign | _floatBits(mant * 5.9604644775390625e-8f));
+  if (e == 31)
+    return _bitsFloat(sign | 0x7f800000u | (mant << 13));
+  return _bitsFloat(sign | ((e + 112) << 23) | (mant << 13));
+}
+
+// bfloat16 bit pattern of <f>, i.e., its upper half rounded to nearest even
+inline uint16_t floatToBf16(float f) {
+  uint32_t u = _floatBits(f);
+  if ((u & 0x7fffffffu) > 0x7f800000u) // NaN, kept quiet
+    return static_cast<uint16_t>((u >> 16) | 0x40u);
+  u += 0x7fffu + ((u >> 16) & 1u);
+  return static_cast<uint16_t>(u >> 16);
+}
+
+inline float bf16ToFloat(uint16_t h) {
+  return _bitsFloat(static_cast<uint32_t>(h) << 16);
+}
+
+inline void u8ToF32Scalar(const uint8_t *src, float *dst, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = static_cast<float>(src[i]);
+}
+
+inline void u8ToU16Scalar(const uint8_t *src, uint16_t *dst, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = src[i];
+}
+
+inline void u8ToF16Scalar(const uint8_t *src, uint16_t *dst, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = u8ToHalf(src[i]);
+}
+
+inline void f32ToF16Scalar(const float *src, uint16_t *dst, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = floatToHalf(src[i]);
+}
+
+inline void f16ToF32Scalar(const uint16_t *src, float *dst, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = halfToFloat(src[i]);
+}
+
+inline void f32ToBf16Scalar(const float *src, uint16_t *dst, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = floatToBf16(src[i]);
+}
+
+inline void bf16ToF32Scalar(const uint16_t *src, float *dst, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = bf16ToFloat(src[i]);
+}
+
+#ifdef CK_X86
+__attribute__((target("sse4.1"))) inline void
+u8ToF32SSE41(const uint8_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)));
+    _mm_storeu_ps(dst + i + 4,
+                  _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 4))));
+    _mm_storeu_ps(dst + i + 8,
+                  _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 8))));
+    _mm_storeu_ps(dst + i + 12,
+                  _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 12))));
+  }
+  u8ToF32Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("sse4.1"))) inline void
+u8ToU16SSE41(const uint8_t *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     _mm_cvtepu8_epi16(v));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8),
+                     _mm_cvtepu8_epi16(_mm_srli_si128(v, 8)));
+  }
+  u8ToU16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline void
+u8ToF32AVX2(const uint8_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)));
+    _mm256_storeu_ps(dst + i + 8, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+                                      _mm_srli_si128(v, 8))));
+  }
+  u8ToF32Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline void
+u8ToU16AVX2(const uint8_t *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 16),
+                        _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+  }
+  u8ToU16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2,f16c"))) inline void
+u8ToF16AVX2(const uint8_t *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i));
+    __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+  }
+  u8ToF16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2,f16c"))) inline void
+f32ToF16AVX2(const float *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(dst + i),
+        _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+  f32ToF16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2,f16c"))) inline void
+f16ToF32AVX2(const uint16_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(
+                                  reinterpret_cast<const __m128i *>(src + i))));
+  f16ToF32Scalar(src + i, dst + i, n - i);
+}
+
+// rounded upper halves of 8 floats as 32-bit lanes, see floatToBf16()
+__attribute__((target("avx2"))) inline __m256i _bf16x8(__m256 x) {
+  __m256i u = _mm256_castps_si256(x);
+  __m256i hi = _mm256_srli_epi32(u, 16);
+  __m256i bias = _mm256_add_epi32(_mm256_set1_epi32(0x7fff),
+                                  _mm256_and_si256(hi, _mm256_set1_epi32(1)));
+  __m256i r = _mm256_srli_epi32(_mm256_add_epi32(u, bias), 16);
+  __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+  return _mm256_blendv_epi8(r, _mm256_or_si256(hi, _mm256_set1_epi32(0x40)),
+                            nan);
+}
+
+__attribute__((target("avx2"))) inline void
+f32ToBf16AVX2(const float *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i lo = _bf16x8(_mm256_loadu_ps(src + i));
+    __m256i hi = _bf16x8(_mm256_loadu_ps(src + i + 8));
+    // packus interleaves the 128-bit lanes, the permute restores the order
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi),
+                                              0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+  }
+  f32ToBf16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline void
+bf16ToF32AVX2(const uint16_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(
+                                  _mm256_cvtepu16_epi32(v), 16)));
+  }
+  bf16ToF32Scalar(src + i, dst + i, n - i);
+}
+
+// GCC 12 warns about _mm512_undefined_* inside its own intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"))) inline void
+u8ToF32AVX512(const uint8_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm512_storeu_ps(dst + i, _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(v)));
+  }
+  u8ToF32Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512bw"))) inline void
+u8ToU16AVX512(const uint8_t *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm512_storeu_si512(dst + i, _mm512_cvtepu8_epi16(v));
+  }
+  u8ToU16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void
+u8ToF16AVX512(const uint8_t *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m512 f = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(v));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm512_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+  }
+  u8ToF16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void
+f32ToF16AVX512(const float *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(dst + i),
+        _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+  f32ToF16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void
+f16ToF32AVX512(const uint16_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(_mm256_loadu_si256(
+                                  reinterpret_cast<const __m256i *>(src + i))));
+  f16ToF32Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void
+f32ToBf16AVX512(const float *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 x = _mm512_loadu_ps(src + i);
+    __m512i u = _mm512_castps_si512(x);
+    __m512i hi = _mm512_srli_epi32(u, 16);
+    __m512i bias = _mm512_add_epi32(
+        _mm512_set1_epi32(0x7fff), _mm512_and_si512(hi, _mm512_set1_epi32(1)));
+    __m512i r = _mm512_srli_epi32(_mm512_add_epi32(u, bias), 16);
+    __mmask16 nan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+    r = _mm512_mask_mov_epi32(r, nan,
+                              _mm512_or_si512(hi, _mm512_set1_epi32(0x40)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm512_cvtepi32_epi16(r));
+  }
+  f32ToBf16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline void
+bf16ToF32AVX512(const uint16_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm512_storeu_ps(dst + i, _mm512_castsi512_ps(_mm512_slli_epi32(
+                                  _mm512_cvtepu16_epi32(v), 16)));
+  }
+  bf16ToF32Scalar(src + i, dst + i, n - i);
+}
+#pragma GCC diagnostic pop
+#endif // CK_X86
+
+// kernels for a given instruction set, which must be supported by the CPU
+inline Kernels kernelsFor(Isa isa) {
+  switch (isa) {
+#ifdef CK_X86
+  case AVX512:
+    return {AVX512,         u8ToF32AVX512,   u8ToU16AVX512,  u8ToF16AVX512,
+            f32ToF16AVX512, f16ToF32AVX512, f32ToBf16AVX512, bf16ToF32AVX512};
+  case AVX2:
+    return {AVX2,         u8ToF32AVX2,  u8ToU16AVX2,   u8ToF16AVX2,
+            f32ToF16AVX2, f16ToF32AVX2, f32ToBf16AVX2, bf16ToF32AVX2};
+  case SSE41:
+    // f16 conversion instructions need F16C, i.e., AVX
+    return {SSE41,          u8ToF32SSE41,   u8ToU16SSE41,    u8ToF16Scalar,
+            f32ToF16Scalar, f16ToF32Scalar, f32ToBf16Scalar, bf16ToF32Scalar};
+#endif
+  default:
+    return {Scalar,         u8ToF32Scalar,  u8ToU16Scalar,   u8ToF16Scalar,
+            f32ToF16Scalar, f16ToF32Scalar, f32ToBf16Scalar, bf16ToF32Scalar};
+  }
+}
+
+// best kernels for this CPU, detected once
+inline const Kernels &kernels() {
+  static const Kernels k = kernelsFor(detectIsa());
+  return k;
+}
+
+inline void u8ToF32(const uint8_t *src, float *dst, size_t n) {
+  kernels().u8ToF32(src, dst, n);
+}
+
+inline void u8ToU16(const uint8_t *src, uint16_t *dst, size_t n) {
+  kernels().u8ToU16(src, dst, n);
+}
+
+inline void u8ToF16(const uint8_t *src, uint16_t *dst, size_t n) {
+  kernels().u8ToF16(src, dst, n);
+}
+
+inline void f32ToF16(const float *src, uint16_t *dst, size_t n) {
+  kernels().f32ToF16(src, dst, n);
+}
+
+inline void f16ToF32(const uint16_t *src, float *dst, size_t n) {
+  kernels().f16ToF32(src, dst, n);
+}
+
+inline void f32ToBf16(const float *src, uint16_t *dst, size_t n) {
+  kernels().f32ToBf16(src, dst, n);
+}
+
+inline void bf16ToF32(const uint16_t *src, float *dst, size_t n) {
+  kernels().bf16ToF32(src, dst, n);
+}
+} // namespace ConvertKernels
+
+#endif // _CONVERT_KERNELS_HPP_
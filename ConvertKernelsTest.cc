@@ -0,0 +1,126 @@
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+#include "ConvertKernels.hpp"
+#include "Exception.h"
+
+using namespace npp;
+using namespace ConvertKernels;
+
+// floats around the edges of the half precision formats
+std::vector<float> halfCases() {
+  std::mt19937 gen(2020);
+  std::vector<float> v = {0.0f,     -0.0f,      1.0f,       -1.0f,   0.1f,
+                          65504.0f, 65519.0f,   65520.0f,   1e6f,    -1e30f,
+                          6.1e-5f,  6.0e-8f,    2.9e-8f,    3.0e-8f, 1e-10f,
+                          3.4e38f,  1.0f / 3.0f, 1.00048828125f};
+  v.push_back(std::numeric_limits<float>::infinity());
+  v.push_back(-std::numeric_limits<float>::infinity());
+  v.push_back(std::numeric_limits<float>::quiet_NaN());
+  v.push_back(std::numeric_limits<float>::denorm_min());
+  std::uniform_int_distribution<uint32_t> bits;
+  std::normal_distribution<float> normal(0.0f, 100.0f);
+  for (int i = 0; i < 2000; ++i) {
+    v.push_back(normal(gen));
+    uint32_t u = bits(gen);
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    v.push_back(f);
+  }
+  return v;
+}
+
+bool sameFloat(float a, float b) {
+  return (a != a && b != b) || std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+int main() {
+  try {
+    NPP_ASSERT(u8ToHalf(0) == 0x0000);
+    NPP_ASSERT(u8ToHalf(1) == 0x3c00);
+    NPP_ASSERT(u8ToHalf(2) == 0x4000);
+    NPP_ASSERT(u8ToHalf(3) == 0x4200);
+    NPP_ASSERT(u8ToHalf(255) == 0x5bf8);
+
+    std::mt19937 gen(2020);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> src(1000);
+    for (auto &v : src)
+      v = static_cast<uint8_t>(dist(gen));
+    for (int v = 0; v < 256; ++v)
+      src[v] = static_cast<uint8_t>(v);
+
+    auto best = detectIsa();
+    std::cout << "detected: " << isaName(best) << std::endl;
+    NPP_ASSERT(kernels().isa == best);
+    for (int isa = Scalar; isa <= best; ++isa) {
+      auto k = kernelsFor(static_cast<Isa>(isa));
+      // odd sizes and offsets exercise the scalar tails
+      for (size_t n : {0, 1, 7, 15, 16, 17, 31, 33, 64, 127, 960}) {
+        for (size_t off : {0, 3}) {
+          std::vector<float> f(n + 1, -1);
+          std::vector<uint16_t> u(n + 1, 0xffff), h(n + 1, 0xffff);
+          k.u8ToF32(&src[off], f.data(), n);
+          k.u8ToU16(&src[off], u.data(), n);
+          k.u8ToF16(&src[off], h.data(), n);
+          for (size_t i = 0; i < n; ++i) {
+            NPP_ASSERT(f[i] == static_cast<float>(src[off + i]));
+            NPP_ASSERT(u[i] == src[off + i]);
+            NPP_ASSERT(h[i] == u8ToHalf(src[off + i]));
+          }
+          // nothing is written past the end
+          NPP_ASSERT(f[n] == -1 && u[n] == 0xffff && h[n] == 0xffff);
+        }
+      }
+    }
+
+    // every binary16/bfloat16 value survives a round trip through float
+    for (uint32_t b = 0; b < 0x10000; ++b) {
+      uint16_t h = static_cast<uint16_t>(b);
+      float f = halfToFloat(h), g = bf16ToFloat(h);
+      if (f == f)
+        NPP_ASSERT(floatToHalf(f) == h);
+      else
+        NPP_ASSERT((floatToHalf(f) & 0x7e00) == 0x7e00); // stays a NaN
+      if (g == g)
+        NPP_ASSERT(floatToBf16(g) == h);
+      else
+        NPP_ASSERT((floatToBf16(g) & 0x7fc0) == 0x7fc0);
+    }
+    NPP_ASSERT(floatToHalf(1.0f) == 0x3c00);
+    NPP_ASSERT(floatToHalf(65520.0f) == 0x7c00); // rounds to inf
+    NPP_ASSERT(floatToHalf(1.00048828125f) == 0x3c00); // tie to even
+    NPP_ASSERT(floatToBf16(1.0f) == 0x3f80);
+    NPP_ASSERT(floatToBf16(1.00390625f) == 0x3f80); // tie to even
+    NPP_ASSERT(floatToBf16(1.01171875f) == 0x3f82);
+
+    auto cases = halfCases();
+    for (int isa = Scalar; isa <= best; ++isa) {
+      auto k = kernelsFor(static_cast<Isa>(isa));
+      for (size_t n : {0, 1, 7, 8, 15, 16, 17, 33, 960, 4000}) {
+        for (size_t off : {0, 3}) {
+          std::vector<uint16_t> h(n + 1, 0xabcd), b(n + 1, 0xabcd);
+          std::vector<float> fh(n + 1, -1), fb(n + 1, -1);
+          k.f32ToF16(&cases[off], h.data(), n);
+          k.f32ToBf16(&cases[off], b.data(), n);
+          k.f16ToF32(h.data(), fh.data(), n);
+          k.bf16ToF32(b.data(), fb.data(), n);
+          for (size_t i = 0; i < n; ++i) {
+            NPP_ASSERT(h[i] == floatToHalf(cases[off + i]));
+            NPP_ASSERT(b[i] == floatToBf16(cases[off + i]));
+            NPP_ASSERT(sameFloat(fh[i], halfToFloat(h[i])));
+            NPP_ASSERT(sameFloat(fb[i], bf16ToFloat(b[i])));
+          }
+          NPP_ASSERT(h[n] == 0xabcd && b[n] == 0xabcd);
+          NPP_ASSERT(fh[n] == -1 && fb[n] == -1);
+        }
+      }
+    }
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#ifndef _DATASET_HPP_
+#define _DATASET_HPP_
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <eigen3/Eigen/Core>
+
+#include "Span.hpp"
+
+// row-major n x dim points in 64-byte aligned memory. Every row is padded
+// with zeros to a multiple of 64 bytes, so each row starts on a cache line
+// and SIMD kernels can use aligned loads and skip tail loops.
+template <typename T> class Dataset {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "dataset elements must be trivially copyable");
+  static_assert(64 % sizeof(T) == 0, "element size must divide 64");
+
+public:
+  static constexpr size_t Alignment = 64;
+  // row lengths are rounded up to a multiple of this many elements
+  static constexpr size_t RowMultiple = Alignment / sizeof(T);
+
+  using RowMajorMatrix =
+      Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using EigenMap =
+      Eigen::Map<RowMajorMatrix, Eigen::Aligned64, Eigen::OuterStride<>>;
+  using ConstEigenMap = Eigen::Map<const RowMajorMatrix, Eigen::Aligned64,
+                                   Eigen::OuterStride<>>;
+
+  Dataset() : _data(nullptr, &free), _n(0), _dim(0), _stride(0) {}
+  Dataset(size_t n, unsigned dim)
+      : _data(nullptr, &free), _n(n), _dim(dim),
+        _stride((dim + RowMultiple - 1) / RowMultiple * RowMultiple) {
+    size_t bytes = _n * _stride * sizeof(T);
+    if (bytes > 0) {
+      void *p = nullptr;
+      if (posix_memalign(&p, Alignment, bytes) != 0)
+        throw std::bad_alloc();
+      std::memset(p, 0, bytes); // padding is zero
+      _data.reset(static_cast<T *>(p));
+    }
+  }
+  // movable but noncopyable
+  Dataset(Dataset &&other)
+      : _data(std::move(other._data)), _n(other._n), _dim(other._dim),
+        _stride(other._stride) {
+    other._n = 0;
+  }
+  Dataset &operator=(Dataset &&other) {
+    _data = std::move(other._data);
+    _n = other._n;
+    _dim = other._dim;
+    _stride = other._stride;
+    other._n = 0;
+    return *this;
+  }
+  Dataset(const Dataset &) = delete;
+  Dataset &operator=(const Dataset &) = delete;
+
+  // get data dimension
+  unsigned pointDimension() const { return _dim; }
+  // total number of points
+  size_t numPoints() const { return _n; }
+  // distance between two consecutive rows (in elements not bytes)
+  size_t stride() const { return _stride; }
+  bool empty() const { return _n == 0; }
+
+  T *data() { return _data.get(); }
+  const T *data() const { return _data.get(); }
+  // all elements including padding
+  Span<T> span() { return Span<T>(data(), _n * _stride); }
+
+  // first coordinate of the i-th point, 64-byte aligned
+  T *row(size_t i) { return data() + i * _stride; }
+  const T *row(size_t i) const { return data() + i * _stride; }
+  T *operator[](size_t i) { return row(i); }
+  const T *operator[](size_t i) const { return row(i); }
+  // j-th coordinate of the i-th point
+  T &operator()(size_t i, unsigned j) { return row(i)[j]; }
+  const T &operator()(size_t i, unsigned j) const { return row(i)[j]; }
+
+  // n x dim Eigen view without the padding, e.g., for GEMV/GEMM
+  EigenMap eigenMap() {
+    return EigenMap(data(), _n, _dim, Eigen::OuterStride<>(_stride));
+  }
+  ConstEigenMap eigenMap() const {
+    return ConstEigenMap(data(), _n, _dim, Eigen::OuterStride<>(_stride));
+  }
+
+private:
+  std::unique_ptr<T, decltype(&free)> _data;
+  size_t _n;
+  unsigned _dim;
+  size_t _stride;
+};
+
+// read the a-th point (including) until b-th point (not including) of
+// <reader>, e.g., a VecsReader, straight into the rows of a dataset
+template <typename T, typename Reader>
+Dataset<T> readDataset(Reader &reader, size_t a, size_t b) {
+  if (b > reader.numPoints())
+    b = reader.numPoints();
+  if (a >= b)
+    return Dataset<T>(0, reader.pointDimension());
+  Dataset<T> ds(b - a, reader.pointDimension());
+  auto n = reader.readInto(ds.span(), a, b, ds.stride());
+  if (n < ds.numPoints()) { // keep the points actually read
+    Dataset<T> part(n, reader.pointDimension());
+    std::memcpy(part.data(), ds.data(), n * ds.stride() * sizeof(T));
+    return part;
+  }
+  return ds;
+}
+
+// read all points of <reader> into a dataset
+template <typename T, typename Reader> Dataset<T> readDataset(Reader &reader) {
+  return readDataset<T>(reader, 0, reader.numPoints());
+}
+
+#endif // _DATASET_HPP_
@@ -0,0 +1,91 @@
+#include <cstdint>
+#include <iostream>
+#include "Dataset.hpp"
+#include "EigenViews.hpp"
+#include "Exception.h"
+#include "VecsReader.h"
+
+using namespace npp;
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+const char *FVF = "./sample-data/gist_query.fvecs";
+
+template <typename T, typename Reader> void checkDataset(Reader &reader) {
+  const unsigned dim = reader.pointDimension();
+  reader.rewind();
+  auto flat = reader.template read<T>();
+  reader.rewind();
+  auto ds = readDataset<T>(reader);
+  NPP_ASSERT(ds.numPoints() == reader.numPoints());
+  NPP_ASSERT(ds.pointDimension() == dim);
+  NPP_ASSERT(ds.stride() >= dim && (ds.stride() * sizeof(T)) % 64 == 0);
+  for (size_t i = 0; i < ds.numPoints(); ++i) {
+    NPP_ASSERT(reinterpret_cast<uintptr_t>(ds.row(i)) % 64 == 0);
+    for (unsigned j = 0; j < dim; ++j)
+      NPP_ASSERT(ds(i, j) == flat[i * dim + j]);
+    for (size_t j = dim; j < ds.stride(); ++j)
+      NPP_ASSERT(ds[i][j] == T(0)); // padding
+  }
+
+  auto part = readDataset<T>(reader, 10, 13);
+  NPP_ASSERT(part.numPoints() == 3 && part(0, 0) == flat[10 * dim]);
+  auto tail = readDataset<T>(reader, reader.numPoints() - 2,
+                             reader.numPoints() + 5);
+  NPP_ASSERT(tail.numPoints() == 2);
+  NPP_ASSERT(readDataset<T>(reader, reader.numPoints(),
+                            reader.numPoints() + 1).empty());
+}
+
+int main() {
+  try {
+    {
+      BvecsReader reader(BVF);
+      checkDataset<float>(reader);
+      checkDataset<uint8_t>(reader);
+    }
+    {
+      FvecsReader reader(FVF);
+      checkDataset<float>(reader);
+
+      // Eigen sees the points without the padding
+      auto ds = readDataset<float>(reader, 0, 100);
+      auto mat = ds.eigenMap();
+      NPP_ASSERT(mat.rows() == 100 && mat.cols() == reader.pointDimension());
+      NPP_ASSERT(mat(7, 3) == ds(7, 3));
+      Eigen::VectorXf x = Eigen::VectorXf::Ones(mat.cols());
+      Eigen::VectorXf y = mat * x;
+      for (size_t i = 0; i < ds.numPoints(); ++i) {
+        float sum = 0;
+        for (unsigned j = 0; j < ds.pointDimension(); ++j)
+          sum += ds(i, j);
+        NPP_ASSERT(std::abs(y(i) - sum) <= 1e-3f * std::abs(sum) + 1e-3f);
+      }
+
+      Dataset<float> moved(std::move(ds));
+      NPP_ASSERT(ds.empty() && moved.numPoints() == 100);
+    }
+
+    {
+      // zero-copy maps of the mapped file, a read buffer and a dataset
+      FvecsReader reader(FVF);
+      auto flat = reader.read(0, 50);
+      auto ds = readDataset<float>(reader, 0, 50);
+      auto view = reader.view(0, 50);
+      auto m1 = eigenMap(flat, reader.pointDimension());
+      auto m2 = eigenMap(view);
+      auto m3 = eigenMap(ds);
+      NPP_ASSERT(m1.rows() == 50 && m1.cols() == reader.pointDimension());
+      NPP_ASSERT(m2.data() == view.data() && m2.outerStride() ==
+                                                 (long)view.stride());
+      NPP_ASSERT(m1 == m2 && m1 == m3);
+      NPP_ASSERT(m2(7, 3) == flat[7 * reader.pointDimension() + 3]);
+      Eigen::VectorXf x = Eigen::VectorXf::Ones(reader.pointDimension());
+      NPP_ASSERT((m2 * x).isApprox(m1 * x));
+      NPP_ASSERT(eigenMap(std::vector<float>(), 4).rows() == 0);
+    }
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
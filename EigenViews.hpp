@@ -0,0 +1,38 @@
+#ifndef _EIGEN_VIEWS_HPP_
+#define _EIGEN_VIEWS_HPP_
+#include <vector>
+
+#include <eigen3/Eigen/Core>
+
+#include "Dataset.hpp"
+#include "VecsView.hpp"
+
+// zero-copy Eigen views of points held by the readers, e.g., for GEMV/GEMM
+// straight on a memory-mapped .fvecs file. Each point is a row of an
+// n x dim row-major matrix whose outer stride is the distance between rows.
+template <typename T>
+using ConstRowMajorMap =
+    Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic,
+                                   Eigen::RowMajor>,
+               Eigen::Unaligned, Eigen::OuterStride<>>;
+
+// view of a VecsView, e.g., from VecsReader::view() or BinVecsReader::view()
+template <typename T> ConstRowMajorMap<T> eigenMap(const VecsView<T> &v) {
+  return ConstRowMajorMap<T>(v.data(), v.numPoints(), v.pointDimension(),
+                             Eigen::OuterStride<>(v.stride()));
+}
+
+// view of contiguous points, e.g., from VecsReader::read()
+template <typename T>
+ConstRowMajorMap<T> eigenMap(const std::vector<T> &data, unsigned dim) {
+  return ConstRowMajorMap<T>(data.data(), dim == 0 ? 0 : data.size() / dim,
+                             dim, Eigen::OuterStride<>(dim));
+}
+
+// view of a dataset, aligned and skipping the row padding
+template <typename T>
+typename Dataset<T>::ConstEigenMap eigenMap(const Dataset<T> &ds) {
+  return ds.eigenMap();
+}
+
+#endif // _EIGEN_VIEWS_HPP_
@@ -0,0 +1,70 @@
+#ifndef _HALF_HPP_
+#define _HALF_HPP_
+#include <cstddef>
+#include <cstdint>
+
+#include "ConvertKernels.hpp"
+
+// 16-bit storage types for coordinates, half the memory of float. Values are
+// converted from float explicitly (rounding to nearest even) and to float
+// implicitly, so arithmetic is carried out in float.
+
+// IEEE 754 binary16: 10-bit mantissa, range +-65504
+struct Float16 {
+  uint16_t bits;
+
+  Float16() = default;
+  explicit Float16(float f) : bits(ConvertKernels::floatToHalf(f)) {}
+  operator float() const { return ConvertKernels::halfToFloat(bits); }
+
+  static Float16 fromBits(uint16_t b) {
+    Float16 h;
+    h.bits = b;
+    return h;
+  }
+};
+
+// bfloat16: the upper half of a float, i.e., 7-bit mantissa with the full
+// float range
+struct BFloat16 {
+  uint16_t bits;
+
+  BFloat16() = default;
+  explicit BFloat16(float f) : bits(ConvertKernels::floatToBf16(f)) {}
+  operator float() const { return ConvertKernels::bf16ToFloat(bits); }
+
+  static BFloat16 fromBits(uint16_t b) {
+    BFloat16 h;
+    h.bits = b;
+    return h;
+  }
+};
+
+static_assert(sizeof(Float16) == 2 && sizeof(BFloat16) == 2,
+              "half types must be 2 bytes");
+
+template <typename T> struct IsHalf {
+  static constexpr bool value = false;
+};
+template <> struct IsHalf<Float16> {
+  static constexpr bool value = true;
+};
+template <> struct IsHalf<BFloat16> {
+  static constexpr bool value = true;
+};
+
+// bulk conversions with the SIMD kernels of this CPU
+inline void floatToHalf(const float *src, Float16 *dst, size_t n) {
+  ConvertKernels::f32ToF16(src, reinterpret_cast<uint16_t *>(dst), n);
+}
+inline void floatToHalf(const float *src, BFloat16 *dst, size_t n) {
+  ConvertKernels::f32ToBf16(src, reinterpret_cast<uint16_t *>(dst), n);
+}
+inline void halfToFloat(const Float16 *src, float *dst, size_t n) {
+  ConvertKernels::f16ToF32(reinterpret_cast<const uint16_t *>(src), dst, n);
+}
+inline void halfToFloat(const BFloat16 *src, float *dst, size_t n) {
+  ConvertKernels::bf16ToF32(reinterpret_cast<const uint16_t *>(src), dst, n);
+}
+
+#endif // _HALF_HPP_
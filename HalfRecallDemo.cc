@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Dataset.hpp"
+#include "Half.hpp"
+#include "VecsReader.h"
+
+// recall of brute-force k-NN over a half precision base set, taking the
+// float32 results as the ground truth: the first <nq> points of the file are
+// the queries and the rest the base set
+
+const char *FVF = "./sample-data/gist_query.fvecs";
+const unsigned K = 10;
+
+float l2(const float *a, const float *b, unsigned dim) {
+  float s = 0;
+  for (unsigned j = 0; j < dim; ++j)
+    s += (a[j] - b[j]) * (a[j] - b[j]);
+  return s;
+}
+
+// ids of the k nearest rows of <base> to every query
+template <typename T>
+std::vector<unsigned> knn(const Dataset<float> &queries,
+                          const Dataset<T> &base) {
+  const unsigned dim = base.pointDimension();
+  std::vector<float> row(dim), dist(base.numPoints());
+  std::vector<unsigned> ids(base.numPoints()), result;
+  for (size_t q = 0; q < queries.numPoints(); ++q) {
+    for (size_t i = 0; i < base.numPoints(); ++i) {
+      if constexpr (std::is_same<T, float>::value) {
+        dist[i] = l2(queries[q], base[i], dim);
+      } else {
+        halfToFloat(base[i], row.data(), dim);
+        dist[i] = l2(queries[q], row.data(), dim);
+      }
+    }
+    std::iota(ids.begin(), ids.end(), 0);
+    auto closer = [&](unsigned a, unsigned b) { return dist[a] < dist[b]; };
+    std::partial_sort(ids.begin(), ids.begin() + K, ids.end(), closer);
+    result.insert(result.end(), ids.begin(), ids.begin() + K);
+  }
+  return result;
+}
+
+double recall(const std::vector<unsigned> &truth,
+              const std::vector<unsigned> &got) {
+  size_t hits = 0;
+  for (size_t q = 0; q < truth.size(); q += K)
+    for (unsigned i = 0; i < K; ++i)
+      hits += std::count(truth.begin() + q, truth.begin() + q + K, got[q + i]);
+  return static_cast<double>(hits) / truth.size();
+}
+
+int main(int argc, char **argv) {
+  if (!(argc == 1 || argc == 2 || argc == 3)) {
+    fprintf(stderr, "Usage: %s [fvecs filename] [# of queries]\n\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::string filename = FVF;
+  if (argc >= 2)
+    filename = argv[1];
+  size_t nq = (argc == 3) ? std::stoul(argv[2]) : 100;
+
+  FvecsReader reader(filename.c_str());
+  if (reader.numPoints() <= nq + K) {
+    fprintf(stderr, "%s has too few points\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  auto queries = readDataset<float>(reader, 0, nq);
+  auto base = readDataset<float>(reader, nq, reader.numPoints());
+  auto base16 = readDataset<Float16>(reader, nq, reader.numPoints());
+  auto baseBf16 = readDataset<BFloat16>(reader, nq, reader.numPoints());
+  printf("# of dim: %u, # of queries: %lu, # of base points: %lu\n",
+         reader.pointDimension(), nq, base.numPoints());
+  printf("base set: float32 %.1f MB, fp16/bf16 %.1f MB\n",
+         base.numPoints() * base.stride() * sizeof(float) / 1e6,
+         base16.numPoints() * base16.stride() * sizeof(Float16) / 1e6);
+
+  auto truth = knn(queries, base);
+  printf("recall@%u fp16: %.4f\n", K, recall(truth, knn(queries, base16)));
+  printf("recall@%u bf16: %.4f\n", K, recall(truth, knn(queries, baseBf16)));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "Dataset.hpp"
+#include "Exception.h"
+#include "Half.hpp"
+#include "VecsReader.h"
+
+using namespace npp;
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+const char *FVF = "./sample-data/gist_query.fvecs";
+
+int main() {
+  try {
+    NPP_ASSERT(Float16(1.0f).bits == 0x3c00);
+    NPP_ASSERT(float(Float16(-2.5f)) == -2.5f);
+    NPP_ASSERT(float(Float16(0.1f)) != 0.1f); // rounded
+    NPP_ASSERT(BFloat16(1.0f).bits == 0x3f80);
+    NPP_ASSERT(float(BFloat16::fromBits(0x4049)) == 3.140625f);
+    NPP_ASSERT(float(Float16(1.0f)) * 2 + float(BFloat16(0.5f)) == 2.5f);
+
+    {
+      // .fvecs into half precision, same as converting each float
+      FvecsReader reader(FVF);
+      auto f = reader.read(0, 100);
+      auto h = reader.read<Float16>(0, 100);
+      auto b = reader.read<BFloat16>(0, 100);
+      NPP_ASSERT(h.size() == f.size() && b.size() == f.size());
+      std::vector<float> back(f.size());
+      halfToFloat(h.data(), back.data(), h.size());
+      for (size_t i = 0; i < f.size(); ++i) {
+        NPP_ASSERT(h[i].bits == Float16(f[i]).bits);
+        NPP_ASSERT(b[i].bits == BFloat16(f[i]).bits);
+        NPP_ASSERT(back[i] == float(h[i]));
+        // 11 and 8 significant bits
+        NPP_ASSERT(std::abs(float(h[i]) - f[i]) <= std::abs(f[i]) / 2048 +
+                                                    6e-8f);
+        NPP_ASSERT(std::abs(float(b[i]) - f[i]) <= std::abs(f[i]) / 256);
+      }
+    }
+
+    {
+      // integers up to 255 are exact in both formats
+      BvecsReader reader(BVF);
+      auto u = reader.read(0, 500);
+      auto h = reader.read<Float16>(0, 500);
+      auto b = reader.read<BFloat16>(0, 500);
+      for (size_t i = 0; i < u.size(); ++i) {
+        NPP_ASSERT(float(h[i]) == u[i]);
+        NPP_ASSERT(float(b[i]) == u[i]);
+      }
+    }
+
+    {
+      // half precision datasets take half the memory of float ones
+      FvecsReader reader(FVF);
+      auto f = readDataset<float>(reader);
+      auto h = readDataset<Float16>(reader);
+      NPP_ASSERT(h.numPoints() == f.numPoints());
+      NPP_ASSERT(h.stride() * sizeof(Float16) * 2 ==
+                 f.stride() * sizeof(float));
+      for (size_t i = 0; i < h.numPoints(); i += 97)
+        for (unsigned j = 0; j < h.pointDimension(); ++j)
+          NPP_ASSERT(h(i, j).bits == Float16(f(i, j)).bits);
+    }
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,462 @@
+#ifndef _IO_ENGINE_HPP_
+#define _IO_ENGINE_HPP_
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) &&                      \
+    __has_include(<linux/io_uring.h>)
+#define IO_ENGINE_HAS_URING 1
+#include <linux/io_uring.h>
+#endif
+
+#include "ParallelUtils.hpp"
+#include "PosixFile.hpp"
+
+// one positioned read of <length> bytes at <offset> into <dst>; <done> is set
+// to the number of bytes read, which is less than <length> only at EOF, and
+// <ios> to the number of blocks read for it, e.g., for the #io of a query
+struct IoRequest {
+  size_t offset;
+  size_t length;
+  char *dst;
+  size_t done;
+  size_t ios = 0;
+};
+
+// batched positioned reads of one file. With <direct> the file is opened
+// with O_DIRECT, bypassing the page cache; requests may then have any
+// offset/length since they are widened to <blockSize> and read through
+// aligned bounce buffers. Requests longer than maxReadSize() are read in
+// parts. Every request reports the blocks it read, which is what the #io
+// column of AnnResultWriter is about; ioCount() is the total of all threads,
+// so it tells the #io of a query only when queries do not overlap.
+class IoEngine {
+public:
+  static constexpr size_t DefaultBlockSize = 4096;
+  // below the 0x7ffff000 bytes Linux returns from one read at most
+  static constexpr size_t DefaultMaxReadSize = 1u << 30;
+
+  IoEngine(const std::string &filename, bool direct,
+           size_t blockSize = DefaultBlockSize)
+      : _file(filename, direct ? O_DIRECT : 0), _direct(direct),
+        _block(blockSize), _maxRead(DefaultMaxReadSize), _ios(0) {}
+  virtual ~IoEngine() = default;
+  IoEngine(const IoEngine &) = delete;
+  IoEngine &operator=(const IoEngine &) = delete;
+
+  virtual const char *name() const = 0;
+  // read all requests, returns once they are complete
+  virtual void submit(std::vector<IoRequest> &reqs) = 0;
+
+  bool direct() const { return _direct; }
+  size_t blockSize() const { return _block; }
+  // largest single read, whole blocks up to DefaultMaxReadSize; lowering it
+  // lets tests split requests into many reads
+  size_t maxReadSize() const { return _maxRead; }
+  void setMaxReadSize(size_t bytes) {
+    _maxRead = std::max(_block, std::min(_alignUp(bytes), DefaultMaxReadSize));
+  }
+  // total size of the file in bytes
+  size_t size() const { return _file.size(); }
+  // number of <blockSize> blocks read so far by all callers
+  size_t ioCount() const { return _ios.load(std::memory_order_relaxed); }
+  void resetIoCount() { _ios.store(0, std::memory_order_relaxed); }
+
+protected:
+  // [first block, last block) covering a request
+  size_t _alignDown(size_t x) const { return x / _block * _block; }
+  size_t _alignUp(size_t x) const { return (x + _block - 1) / _block * _block; }
+  void _countIos(IoRequest &r) {
+    r.ios = 0;
+    if (r.length > 0)
+      r.ios = (_alignUp(r.offset + r.length) - _alignDown(r.offset)) / _block;
+    _ios.fetch_add(r.ios, std::memory_order_relaxed);
+  }
+
+  // memory aligned for O_DIRECT
+  struct AlignedBuffer {
+    AlignedBuffer() : data(nullptr), size(0) {}
+    ~AlignedBuffer() { free(data); }
+    AlignedBuffer(const AlignedBuffer &) = delete;
+    AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+    void reserve(size_t sz, size_t alignment) {
+      if (sz <= size)
+        return;
+      free(data);
+      data = nullptr;
+      if (posix_memalign(reinterpret_cast<void **>(&data), alignment, sz) != 0)
+        throw std::bad_alloc();
+      size = sz;
+    }
+    char *data;
+    size_t size;
+  };
+
+  PosixFile _file;
+  bool _direct;
+  size_t _block;
+  size_t _maxRead;
+  std::atomic<size_t> _ios;
+};
+
+// runs the requests with concurrent preads from <numThreads> threads; with
+// O_DIRECT every thread reads through one bounce window of at most
+// <BounceSize> bytes, so long requests do not need a second copy in memory
+class PreadIoEngine : public IoEngine {
+public:
+  static constexpr size_t BounceSize = 1 << 20;
+
+  PreadIoEngine(const std::string &filename, bool direct = false,
+                unsigned numThreads = 0,
+                size_t blockSize = IoEngine::DefaultBlockSize)
+      : IoEngine(filename, direct, blockSize), _threads(numThreads) {}
+
+  const char *name() const override { return "pread"; }
+
+  void submit(std::vector<IoRequest> &reqs) override {
+    ParallelUtils::parallelFor(
+        reqs.size(), _threads, [&](size_t a, size_t b, unsigned /* tid */) {
+          AlignedBuffer bounce;
+          for (size_t i = a; i < b; ++i) {
+            auto &r = reqs[i];
+            _countIos(r);
+            if (!_direct) {
+              r.done = _file.pread(r.dst, r.length, r.offset);
+              continue;
+            }
+            size_t first = _alignDown(r.offset);
+            size_t last = _alignUp(r.offset + r.length);
+            size_t window = std::min({last - first, BounceSize, _maxRead});
+            bounce.reserve(window, _block);
+            r.done = 0;
+            for (size_t pos = first; pos < last; pos += window) {
+              size_t len = std::min(window, last - pos);
+              size_t got = _directRead(bounce.data, len, pos);
+              // the part of [pos, pos + got) that the request asked for
+              size_t lo = std::max(pos, r.offset);
+              size_t hi = std::min(pos + got, r.offset + r.length);
+              if (hi > lo) {
+                std::memcpy(r.dst + (lo - r.offset), bounce.data + (lo - pos),
+                            hi - lo);
+                r.done = hi - r.offset;
+              }
+              if (got < len)
+                break; // EOF
+            }
+          }
+        });
+  }
+
+private:
+  // aligned reads of <len> bytes, less only at EOF: a read returning 0 or a
+  // partial block ends the file, as the rest would be unaligned
+  size_t _directRead(char *buf, size_t len, size_t offset) const {
+    size_t done = 0;
+    while (done < len) {
+      ssize_t r = ::pread(_file.fd(), buf + done, len - done, offset + done);
+      if (r < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::runtime_error(
+            "PreadIoEngine::submit(): Failed to read file " +
+            _file.filename() + ": " + std::strerror(errno));
+      }
+      done += r;
+      if (r == 0 || r % _block != 0)
+        break; // EOF
+    }
+    return done;
+  }
+
+  unsigned _threads;
+};
+
+#ifdef IO_ENGINE_HAS_URING
+// submits the requests in batches through an io_uring, using the raw
+// syscalls so that liburing is not needed
+class UringIoEngine : public IoEngine {
+public:
+  UringIoEngine(const std::string &filename, bool direct = true,
+                unsigned queueDepth = 64,
+                size_t blockSize = IoEngine::DefaultBlockSize)
+      : IoEngine(filename, direct, blockSize), _ring_fd(-1),
+        _sq_ptr(MAP_FAILED), _cq_ptr(MAP_FAILED), _sqes(MAP_FAILED) {
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    _ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &p));
+    if (_ring_fd < 0)
+      throw std::runtime_error(
+          std::string("UringIoEngine::UringIoEngine(): io_uring_setup "
+                      "failed: ") +
+          std::strerror(errno));
+    _sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    _cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    _single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (_single)
+      _sq_sz = _cq_sz = std::max(_sq_sz, _cq_sz);
+    _sq_ptr = ::mmap(nullptr, _sq_sz, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+    _cq_ptr = _single ? _sq_ptr
+                      : ::mmap(nullptr, _cq_sz, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, _ring_fd,
+                               IORING_OFF_CQ_RING);
+    _sqes_sz = p.sq_entries * sizeof(io_uring_sqe);
+    _sqes = ::mmap(nullptr, _sqes_sz, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+    if (_sq_ptr == MAP_FAILED || _cq_ptr == MAP_FAILED ||
+        _sqes == MAP_FAILED) {
+      _release();
+      throw std::runtime_error(
+          "UringIoEngine::UringIoEngine(): mapping the rings failed");
+    }
+    char *sq = static_cast<char *>(_sq_ptr);
+    char *cq = static_cast<char *>(_cq_ptr);
+    _sq_tail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    _sq_mask = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    _sq_array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+    _cq_head = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    _cq_mask = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    _entries = p.sq_entries;
+  }
+
+  ~UringIoEngine() override { _release(); }
+
+  const char *name() const override { return "io_uring"; }
+
+  void submit(std::vector<IoRequest> &reqs) override {
+    std::lock_guard<std::mutex> lock(_mutex); // one batch at a time
+    // per request target and progress, reads land in bounce buffers with
+    // O_DIRECT and straight in the destination otherwise
+    std::vector<Pending> pending(reqs.size());
+    std::vector<AlignedBuffer> bounces(_direct ? reqs.size() : 0);
+    for (size_t i = 0; i < reqs.size(); ++i) {
+      auto &r = reqs[i];
+      _countIos(r);
+      r.done = 0;
+      auto &p = pending[i];
+      if (_direct) {
+        p.offset = _alignDown(r.offset);
+        p.length = _alignUp(r.offset + r.length) - p.offset;
+        bounces[i].reserve(p.length, _block);
+        p.buf = bounces[i].data;
+      } else {
+        p.offset = r.offset;
+        p.length = r.length;
+        p.buf = r.dst;
+      }
+      p.done = 0;
+    }
+
+    size_t next = 0, inflight = 0, finished = 0;
+    std::vector<size_t> retry;
+    while (finished < reqs.size()) {
+      unsigned queued = 0;
+      while (inflight + queued < _entries &&
+             (!retry.empty() || next < reqs.size())) {
+        size_t i;
+        if (!retry.empty()) {
+          i = retry.back();
+          retry.pop_back();
+        } else {
+          i = next++;
+        }
+        if (pending[i].length == 0) { // nothing to read
+          ++finished;
+          continue;
+        }
+        _queue(i, pending[i]);
+        ++queued;
+      }
+      inflight += queued;
+      if (inflight == 0)
+        continue;
+      _enter(queued, 1);
+      unsigned head = *_cq_head;
+      unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = _cqes[head & _cq_mask];
+        auto &p = pending[cqe.user_data];
+        --inflight;
+        if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+          retry.push_back(cqe.user_data);
+        } else if (cqe.res < 0) {
+          __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+          _drain(inflight);
+          throw std::runtime_error(
+              std::string("UringIoEngine::submit(): read failed: ") +
+              std::strerror(-cqe.res));
+        } else {
+          p.done += cqe.res;
+          // 0 bytes is EOF, and so is a partial block with O_DIRECT as the
+          // rest would be unaligned; otherwise the rest of a request longer
+          // than one read or cut short is queued again
+          if (cqe.res == 0 || p.done == p.length ||
+              (_direct && cqe.res % _block != 0))
+            ++finished; // EOF or complete
+          else
+            retry.push_back(cqe.user_data);
+        }
+      }
+      __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    for (size_t i = 0; i < reqs.size(); ++i) {
+      auto &r = reqs[i];
+      auto &p = pending[i];
+      if (!_direct) {
+        r.done = p.done;
+        continue;
+      }
+      size_t skip = r.offset - p.offset;
+      r.done = p.done > skip ? std::min(r.length, p.done - skip) : 0;
+      std::memcpy(r.dst, p.buf + skip, r.done);
+    }
+  }
+
+private:
+  struct Pending {
+    size_t offset;
+    size_t length;
+    char *buf;
+    size_t done;
+  };
+
+  // put the remaining part of pending read <i> into the submission queue
+  void _queue(size_t i, const Pending &p) {
+    unsigned tail = *_sq_tail;
+    unsigned idx = tail & _sq_mask;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(_sqes) + idx;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = _file.fd();
+    sqe->addr = reinterpret_cast<uint64_t>(p.buf + p.done);
+    sqe->len = static_cast<unsigned>(std::min(p.length - p.done, _maxRead));
+    sqe->off = p.offset + p.done;
+    sqe->user_data = i;
+    _sq_array[idx] = idx;
+    __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  void _enter(unsigned toSubmit, unsigned minComplete) {
+    for (;;) {
+      long r = syscall(__NR_io_uring_enter, _ring_fd, toSubmit, minComplete,
+                       IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (r >= 0)
+        return;
+      if (errno != EINTR)
+        throw std::runtime_error(
+            std::string("UringIoEngine::submit(): io_uring_enter failed: ") +
+            std::strerror(errno));
+    }
+  }
+
+  // wait for reads still in flight after an error, their buffers go away
+  void _drain(size_t inflight) {
+    while (inflight > 0) {
+      try {
+        _enter(0, 1);
+      } catch (const std::exception &) {
+        return;
+      }
+      unsigned head = *_cq_head;
+      unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+      inflight -= std::min<size_t>(inflight, tail - head);
+      __atomic_store_n(_cq_head, tail, __ATOMIC_RELEASE);
+    }
+  }
+
+  void _release() {
+    if (_sqes != MAP_FAILED)
+      ::munmap(_sqes, _sqes_sz);
+    if (_cq_ptr != MAP_FAILED && !_single)
+      ::munmap(_cq_ptr, _cq_sz);
+    if (_sq_ptr != MAP_FAILED)
+      ::munmap(_sq_ptr, _sq_sz);
+    if (_ring_fd >= 0)
+      ::close(_ring_fd);
+  }
+
+  int _ring_fd;
+  void *_sq_ptr;
+  void *_cq_ptr;
+  void *_sqes;
+  size_t _sq_sz, _cq_sz, _sqes_sz;
+  bool _single;
+  unsigned _entries;
+  unsigned *_sq_tail, *_sq_array, _sq_mask;
+  unsigned *_cq_head, *_cq_tail, _cq_mask;
+  io_uring_cqe *_cqes;
+  std::mutex _mutex;
+};
+#endif // IO_ENGINE_HAS_URING
+
+enum class IoBackend { Auto, Uring, Pread };
+
+// whether reads through <engine> work; some file systems accept O_DIRECT at
+// open but fail the reads with EINVAL
+inline bool _readsWork(IoEngine &engine) {
+  std::vector<char> buf(std::min(engine.size(), engine.blockSize()));
+  std::vector<IoRequest> probe = {{0, buf.size(), buf.data(), 0}};
+  try {
+    engine.submit(probe);
+  } catch (const std::exception &) {
+    return false;
+  }
+  engine.resetIoCount();
+  return probe[0].done == probe[0].length;
+}
+
+// engine for <filename>; Auto prefers io_uring and falls back to preads when
+// it is unavailable, and drops O_DIRECT if the file system refuses it at open
+// or on the first read
+inline std::unique_ptr<IoEngine>
+makeIoEngine(const std::string &filename, IoBackend backend = IoBackend::Auto,
+             bool direct = true, unsigned numThreads = 0) {
+  if (backend != IoBackend::Pread) {
+#ifdef IO_ENGINE_HAS_URING
+    for (bool d : {direct, false}) {
+      try {
+        std::unique_ptr<IoEngine> engine(new UringIoEngine(filename, d));
+        if (!d || _readsWork(*engine))
+          return engine;
+      } catch (const std::exception &) {
+        if (backend == IoBackend::Uring && d == false)
+          throw;
+      }
+      if (!direct)
+        break;
+    }
+#else
+    if (backend == IoBackend::Uring)
+      throw std::runtime_error("makeIoEngine(): io_uring is not supported");
+#endif
+  }
+  if (direct) {
+    try {
+      std::unique_ptr<IoEngine> engine(
+          new PreadIoEngine(filename, true, numThreads));
+      if (_readsWork(*engine))
+        return engine;
+    } catch (const std::exception &) {
+    }
+  }
+  return std::unique_ptr<IoEngine>(
+      new PreadIoEngine(filename, false, numThreads));
+}
+
+#endif // _IO_ENGINE_HPP_
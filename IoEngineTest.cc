@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "AnnResultWriter.hpp"
+#include "Exception.h"
+#include "IoEngine.hpp"
+#include "VecsReader.h"
+
+using namespace npp;
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+
+// random unaligned requests must return the same bytes as the file
+void checkEngine(IoEngine &engine, const std::vector<char> &content) {
+  std::mt19937 gen(2020);
+  std::uniform_int_distribution<size_t> dist(0, content.size() - 1);
+  std::vector<IoRequest> reqs(200);
+  std::vector<std::vector<char>> bufs(reqs.size());
+  for (size_t i = 0; i < reqs.size(); ++i) {
+    size_t off = dist(gen), len = dist(gen) % 20000;
+    bufs[i].resize(len);
+    reqs[i] = {off, len, bufs[i].data(), 0};
+  }
+  std::vector<char> tail(100);
+  reqs.push_back({content.size() - 10, tail.size(), tail.data(), 0});
+
+  engine.resetIoCount();
+  engine.submit(reqs);
+  size_t blocks = 0;
+  for (const auto &r : reqs) {
+    size_t expect = std::min(r.length, content.size() - r.offset);
+    NPP_ASSERT(r.done == expect);
+    NPP_ASSERT(std::equal(r.dst, r.dst + r.done, &content[r.offset]));
+    size_t ios = 0;
+    if (r.length > 0)
+      ios = (r.offset + r.length - 1) / engine.blockSize() -
+            r.offset / engine.blockSize() + 1;
+    NPP_ASSERT(r.ios == ios);
+    blocks += ios;
+  }
+  NPP_ASSERT(engine.ioCount() == blocks);
+}
+
+// requests over many reads, with the read size lowered to 3 blocks, come
+// back whole
+void checkLongReads(IoEngine &engine, const std::vector<char> &content) {
+  engine.setMaxReadSize(3 * engine.blockSize());
+  NPP_ASSERT(engine.maxReadSize() == 3 * engine.blockSize());
+  std::vector<char> all(content.size() + 100), mid(content.size() - 5007);
+  std::vector<IoRequest> reqs = {{0, all.size(), all.data(), 0},
+                                 {5000, mid.size(), mid.data(), 0}};
+  engine.submit(reqs);
+  NPP_ASSERT(reqs[0].done == content.size() && reqs[1].done == mid.size());
+  NPP_ASSERT(std::equal(content.begin(), content.end(), all.begin()));
+  NPP_ASSERT(std::equal(mid.begin(), mid.end(), &content[5000]));
+  engine.setMaxReadSize(IoEngine::DefaultMaxReadSize);
+}
+
+int main() {
+  try {
+    std::vector<char> content;
+    {
+      PosixFile file(BVF);
+      content.resize(file.size());
+      NPP_ASSERT(file.pread(content.data(), content.size(), 0) ==
+                 content.size());
+    }
+
+    std::vector<std::unique_ptr<IoEngine>> engines;
+    engines.emplace_back(new PreadIoEngine(BVF, false, 4));
+    try {
+      engines.emplace_back(new PreadIoEngine(BVF, true, 4));
+    } catch (const std::exception &e) {
+      std::cout << "O_DIRECT unavailable: " << e.what() << std::endl;
+    }
+#ifdef IO_ENGINE_HAS_URING
+    for (bool direct : {false, true}) {
+      try {
+        engines.emplace_back(new UringIoEngine(BVF, direct, 8));
+      } catch (const std::exception &e) {
+        std::cout << "io_uring unavailable: " << e.what() << std::endl;
+      }
+    }
+#endif
+    engines.emplace_back(makeIoEngine(BVF));
+    for (auto &engine : engines) {
+      std::cout << "engine: " << engine->name()
+                << (engine->direct() ? " (O_DIRECT)" : "") << std::endl;
+      checkEngine(*engine, content);
+      checkLongReads(*engine, content);
+    }
+
+    {
+      // readers produce the same points through the engine
+      BvecsReader plain(BVF), reader(BVF);
+      std::shared_ptr<IoEngine> engine = makeIoEngine(BVF);
+      reader.setIoEngine(engine);
+      auto all = reader.loadAll<float>(2);
+      auto expect = plain.read<float>();
+      NPP_ASSERT(std::equal(all.begin(), all.end(), expect.begin(),
+                            expect.end()));
+      plain.rewind();
+      std::vector<size_t> ids = {9, 1, 5000, 5001, 9999, 1};
+      NPP_ASSERT(reader.gather(ids) == plain.gather(ids));
+      NPP_ASSERT(reader.read(100, 300) == plain.read(100, 300));
+      NPP_ASSERT(reader.read(2) == plain.read(2)); // stream continues at 300
+      NPP_ASSERT(reader.read(9990, 10010) == plain.read(9990, 10010));
+      reader.rewind();
+      plain.rewind();
+      NPP_ASSERT(reader.read(3) == plain.read(3));
+
+      // report the block I/Os of every query in the #io column
+      AnnResultWriter writer("io-engine-test.txt", true);
+      writer.writeRow("s", AnnResults::_DEFAULT_HEADER_E_);
+      for (int q = 0; q < 3; ++q) {
+        size_t ios;
+        auto rows = reader.gather({size_t(q), size_t(q) + 1000}, 8, 1, &ios);
+        int io = static_cast<int>(ios);
+        NPP_ASSERT(io == 2);
+        NPP_ASSERT(writer.writeRow(AnnResults::_DEFAULT_FMT_E_, q, 1, q, 0, 0,
+                                   1.0, 1.0, io));
+      }
+    }
+    remove("io-engine-test.txt");
+
+    {
+      // range reads through the engine check the dim of every point
+      std::vector<char> bad = content;
+      int dim = 129;
+      std::memcpy(&bad[13 * (sizeof(int) + 128)], &dim, sizeof(int));
+      FILE *fp = fopen("io-engine-test.bvecs", "wb");
+      fwrite(bad.data(), 1, bad.size(), fp);
+      fclose(fp);
+      BvecsReader reader("io-engine-test.bvecs");
+      reader.setIoEngine(makeIoEngine("io-engine-test.bvecs"));
+      NPP_ASSERT(reader.read(0, 13).size() == 13 * 128);
+      bool thrown = false;
+      try {
+        reader.read(10, 20);
+      } catch (const VecsReaderException &e) {
+        thrown = std::string(e.what()).find("Point 13") != std::string::npos;
+      }
+      NPP_ASSERT(thrown);
+      remove("io-engine-test.bvecs");
+    }
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+#ifndef _LATENCY_HISTOGRAM_HPP_
+#define _LATENCY_HISTOGRAM_HPP_
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ConcurrentLatencyHistogram;
+
+// log-linear histogram of non-negative integer values, e.g., latencies in
+// nanoseconds, in the spirit of HdrHistogram: values below 2 * SubBuckets are
+// counted exactly and every larger power of 2 is split into SubBuckets
+// linear buckets, so any value in [0, 2^64) is kept with a relative error
+// below 1 / SubBuckets in a fixed number of counters. Histograms of different
+// threads are combined with merge().
+class LatencyHistogram {
+public:
+  static constexpr unsigned SubBits = 7;
+  static constexpr uint64_t SubBuckets = uint64_t(1) << SubBits;
+  static constexpr size_t NumBuckets = SubBuckets * (64 - SubBits + 1);
+
+  LatencyHistogram() : _counts(NumBuckets, 0) { reset(); }
+
+  void record(uint64_t v, uint64_t count = 1) {
+    _counts[bucketOf(v)] += count;
+    _total += count;
+    _sum += static_cast<double>(v) * count;
+    if (v < _min)
+      _min = v;
+    if (v > _max)
+      _max = v;
+  }
+
+  void merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < NumBuckets; ++i)
+      _counts[i] += other._counts[i];
+    _total += other._total;
+    _sum += other._sum;
+    if (other._min < _min)
+      _min = other._min;
+    if (other._max > _max)
+      _max = other._max;
+  }
+
+  void reset() {
+    std::fill(_counts.begin(), _counts.end(), 0);
+    _total = 0;
+    _sum = 0;
+    _min = std::numeric_limits<uint64_t>::max();
+    _max = 0;
+  }
+
+  uint64_t count() const { return _total; }
+  bool empty() const { return _total == 0; }
+  // exact extremes and mean of the recorded values
+  uint64_t min() const { return _total == 0 ? 0 : _min; }
+  uint64_t max() const { return _max; }
+  double mean() const { return _total == 0 ? 0 : _sum / _total; }
+
+  // smallest value v such that at least <p> percent of the recorded values
+  // are <= v, up to the bucket resolution; 0 if empty
+  uint64_t percentile(double p) const {
+    if (_total == 0)
+      return 0;
+    double rank = p / 100 * _total;
+    uint64_t need = rank <= 1 ? 1 : static_cast<uint64_t>(rank + 0.9999999);
+    if (need > _total)
+      need = _total;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NumBuckets; ++i) {
+      seen += _counts[i];
+      if (seen >= need) {
+        uint64_t v = bucketHigh(i);
+        return v < _min ? _min : (v > _max ? _max : v);
+      }
+    }
+    return _max;
+  }
+
+  // the usual tail percentiles, e.g., for watching a long run
+  struct Percentiles {
+    uint64_t p50, p90, p99, p999, max;
+  };
+  Percentiles percentiles() const {
+    return {percentile(50), percentile(90), percentile(99), percentile(99.9),
+            max()};
+  }
+
+  // one line of the count and percentiles, the values multiplied by <scale>,
+  // e.g., 1e-3 for nanoseconds shown as microseconds
+  std::string summary(double scale = 1e-3) const {
+    Percentiles p = percentiles();
+    char line[256];
+    snprintf(line, sizeof(line),
+             "n=%llu mean=%.3f p50=%.3f p90=%.3f p99=%.3f p999=%.3f max=%.3f",
+             static_cast<unsigned long long>(_total), mean() * scale,
+             p.p50 * scale, p.p90 * scale, p.p99 * scale, p.p999 * scale,
+             p.max * scale);
+    return line;
+  }
+
+  // counters of bucket <i>, e.g., for dumping the distribution
+  uint64_t bucketCount(size_t i) const { return _counts[i]; }
+
+  static size_t bucketOf(uint64_t v) {
+    if (v < 2 * SubBuckets)
+      return static_cast<size_t>(v);
+    unsigned shift = 63 - __builtin_clzll(v) - SubBits;
+    return static_cast<size_t>(SubBuckets * shift + (v >> shift));
+  }
+  // smallest and largest value counted in bucket <i>
+  static uint64_t bucketLow(size_t i) {
+    if (i < 2 * SubBuckets)
+      return i;
+    uint64_t shift = i / SubBuckets - 1;
+    return (i - SubBuckets * shift) << shift;
+  }
+  static uint64_t bucketHigh(size_t i) {
+    if (i < 2 * SubBuckets)
+      return i;
+    uint64_t shift = i / SubBuckets - 1;
+    return bucketLow(i) + ((uint64_t(1) << shift) - 1);
+  }
+
+private:
+  friend class ConcurrentLatencyHistogram;
+
+  std::vector<uint64_t> _counts;
+  uint64_t _total;
+  double _sum;
+  uint64_t _min;
+  uint64_t _max;
+};
+
+// LatencyHistogram with lock-free record(), so worker threads may share one
+// histogram and another thread may read it while they run, e.g., to print
+// the tail latencies of a long benchmark every few seconds. A record is a
+// relaxed fetch_add on its bucket and on the sum, plus a compare-and-swap
+// only when it is a new minimum or maximum. Threads that do not need to be
+// watched are cheaper with their own LatencyHistogram, merged at the end.
+class ConcurrentLatencyHistogram {
+public:
+  static constexpr size_t NumBuckets = LatencyHistogram::NumBuckets;
+
+  ConcurrentLatencyHistogram()
+      : _counts(new std::atomic<uint64_t>[NumBuckets]) {
+    reset();
+  }
+
+  void record(uint64_t v, uint64_t count = 1) {
+    _counts[LatencyHistogram::bucketOf(v)].fetch_add(
+        count, std::memory_order_relaxed);
+    _sum.fetch_add(v * count, std::memory_order_relaxed);
+    uint64_t m = _min.load(std::memory_order_relaxed);
+    while (v < m && !_min.compare_exchange_weak(m, v,
+                                                std::memory_order_relaxed))
+      ;
+    m = _max.load(std::memory_order_relaxed);
+    while (v > m && !_max.compare_exchange_weak(m, v,
+                                                std::memory_order_relaxed))
+      ;
+  }
+
+  // copy of the counters for the percentile queries; records running
+  // concurrently may be partially included
+  LatencyHistogram snapshot() const {
+    LatencyHistogram h;
+    mergeInto(h);
+    return h;
+  }
+
+  // add the counters to <h>, e.g., the histograms of several runs
+  void mergeInto(LatencyHistogram &h) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < NumBuckets; ++i) {
+      uint64_t c = _counts[i].load(std::memory_order_relaxed);
+      h._counts[i] += c;
+      total += c;
+    }
+    if (total == 0)
+      return;
+    h._total += total;
+    h._sum += static_cast<double>(_sum.load(std::memory_order_relaxed));
+    h._min = std::min(h._min, _min.load(std::memory_order_relaxed));
+    h._max = std::max(h._max, _max.load(std::memory_order_relaxed));
+  }
+
+  // not concurrently with record()
+  void reset() {
+    for (size_t i = 0; i < NumBuckets; ++i)
+      _counts[i].store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _min.store(std::numeric_limits<uint64_t>::max(),
+               std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  std::unique_ptr<std::atomic<uint64_t>[]> _counts;
+  std::atomic<uint64_t> _sum; // wraps after 584 years of nanoseconds
+  std::atomic<uint64_t> _min;
+  std::atomic<uint64_t> _max;
+};
+
+#endif // _LATENCY_HISTOGRAM_HPP_
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "LatencyHistogram.hpp"
+#include "Timer.hpp"
+
+using namespace npp;
+
+int main() {
+  try {
+    // every value lies in its bucket and buckets are narrow
+    std::mt19937_64 gen(2020);
+    for (int i = 0; i < 1000000; ++i) {
+      uint64_t v = gen() >> (gen() % 64);
+      size_t b = LatencyHistogram::bucketOf(v);
+      NPP_ASSERT(b < LatencyHistogram::NumBuckets);
+      NPP_ASSERT(LatencyHistogram::bucketLow(b) <= v &&
+                 v <= LatencyHistogram::bucketHigh(b));
+      NPP_ASSERT(LatencyHistogram::bucketHigh(b) -
+                     LatencyHistogram::bucketLow(b) <=
+                 v / LatencyHistogram::SubBuckets);
+    }
+    NPP_ASSERT(LatencyHistogram::bucketOf(UINT64_MAX) ==
+               LatencyHistogram::NumBuckets - 1);
+    for (size_t b = 1; b < LatencyHistogram::NumBuckets; ++b)
+      NPP_ASSERT(LatencyHistogram::bucketLow(b) ==
+                 LatencyHistogram::bucketHigh(b - 1) + 1);
+
+    // percentiles of log-normal latencies, about 20us, against the exact
+    // ones; two halves merged are the same as one histogram
+    std::lognormal_distribution<double> dist(std::log(20000.0), 0.5);
+    std::vector<uint64_t> values(200000);
+    LatencyHistogram all, first, second;
+    for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = static_cast<uint64_t>(dist(gen));
+      all.record(values[i]);
+      (i % 2 == 0 ? first : second).record(values[i]);
+    }
+    first.merge(second);
+    std::sort(values.begin(), values.end());
+    NPP_ASSERT(all.count() == values.size());
+    NPP_ASSERT(all.min() == values.front() && all.max() == values.back());
+    for (double p : {0.0, 1.0, 50.0, 90.0, 99.0, 99.9, 100.0}) {
+      size_t rank = static_cast<size_t>(std::ceil(p / 100 * values.size()));
+      uint64_t exact = values[rank == 0 ? 0 : rank - 1];
+      uint64_t v = all.percentile(p);
+      NPP_ASSERT(v >= exact && v - exact <= exact / LatencyHistogram::SubBuckets);
+      NPP_ASSERT(first.percentile(p) == v);
+    }
+    NPP_ASSERT(std::abs(first.mean() - all.mean()) < 1e-6 * all.mean());
+    std::cout << "p50 " << all.percentile(50) << " p99 " << all.percentile(99)
+              << " p99.9 " << all.percentile(99.9) << " max " << all.max()
+              << std::endl;
+
+    LatencyHistogram small;
+    NPP_ASSERT(small.empty() && small.percentile(50) == 0 && small.min() == 0);
+    small.record(3, 10);
+    small.record(1000);
+    NPP_ASSERT(small.count() == 11 && small.percentile(90) == 3);
+    NPP_ASSERT(small.percentile(100) == 1000);
+    small.reset();
+    NPP_ASSERT(small.empty() && small.max() == 0);
+
+    LatencyHistogram::Percentiles ps = all.percentiles();
+    NPP_ASSERT(ps.p50 == all.percentile(50) && ps.p90 == all.percentile(90) &&
+               ps.p99 == all.percentile(99) &&
+               ps.p999 == all.percentile(99.9) && ps.max == all.max());
+    NPP_ASSERT(ps.p50 <= ps.p90 && ps.p90 <= ps.p99 && ps.p99 <= ps.p999 &&
+               ps.p999 <= ps.max);
+    std::cout << all.summary() << std::endl;
+
+    // several threads record into one histogram while it is read, and end
+    // up with the same counters as a single thread
+    const unsigned numThreads = 4;
+    ConcurrentLatencyHistogram shared;
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; ++t)
+      threads.emplace_back([&, t] {
+        for (size_t i = t; i < values.size(); i += numThreads)
+          shared.record(values[i]);
+      });
+    for (int i = 0; i < 10; ++i) { // live view, counts only grow
+      LatencyHistogram live = shared.snapshot();
+      NPP_ASSERT(live.count() <= values.size());
+    }
+    for (auto &th : threads)
+      th.join();
+    LatencyHistogram snap = shared.snapshot();
+    NPP_ASSERT(snap.count() == all.count());
+    NPP_ASSERT(snap.min() == all.min() && snap.max() == all.max());
+    NPP_ASSERT(std::abs(snap.mean() - all.mean()) < 1e-6 * all.mean());
+    for (size_t b = 0; b < LatencyHistogram::NumBuckets; ++b)
+      NPP_ASSERT(snap.bucketCount(b) == all.bucketCount(b));
+    LatencyHistogram twice = snap;
+    shared.mergeInto(twice);
+    NPP_ASSERT(twice.count() == 2 * all.count() &&
+               twice.percentile(99) == all.percentile(99));
+    shared.reset();
+    NPP_ASSERT(shared.snapshot().empty());
+
+    // timers record nanoseconds and return microseconds
+    LatencyHistogram times;
+    HighResolutionTimer hrt;
+    hrt.restart();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    double us = recordElapsed(hrt, times);
+    RdtscTimer rt;
+    rt.restart();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    us = std::min(us, recordElapsed(rt, shared));
+    NPP_ASSERT(us >= 2000);
+    NPP_ASSERT(times.count() == 1 && times.min() >= 2000000);
+    NPP_ASSERT(shared.snapshot().count() == 1 &&
+               shared.snapshot().min() >= 1900000);
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#ifndef _MAPPED_FILE_HPP_
+#define _MAPPED_FILE_HPP_
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// read-only memory mapping of a whole file
+class MappedFile {
+public:
+  // access pattern hints forwarded to madvise
+  enum Advice { Normal, Sequential, Random, WillNeed };
+
+  explicit MappedFile(const std::string &filename)
+      : _filename(filename), _data(nullptr), _size(0) {
+    int fd = ::open(_filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error(
+          "MappedFile::MappedFile(): Failed to open file " + _filename + ": " +
+          std::strerror(errno));
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error(
+          "MappedFile::MappedFile(): Failed to stat file " + _filename + ": " +
+          std::strerror(errno));
+    }
+    _size = st.st_size;
+    if (_size > 0) {
+      void *p = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error(
+            "MappedFile::MappedFile(): Failed to map file " + _filename + ": " +
+            std::strerror(errno));
+      }
+      _data = static_cast<const char *>(p);
+    }
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if (_data)
+      ::munmap(const_cast<char *>(_data), _size);
+  }
+
+  // first byte of the mapping
+  const char *data() const { return _data; }
+  // total size in bytes
+  size_t size() const { return _size; }
+
+  // hint the kernel about how [offset, offset + len) will be accessed
+  bool advise(Advice advice, size_t offset = 0, size_t len = 0) {
+    if (!_data || offset >= _size)
+      return false;
+    if (len == 0 || offset + len > _size)
+      len = _size - offset;
+    // madvise requires a page aligned start address
+    static const size_t page = ::sysconf(_SC_PAGESIZE);
+    size_t begin = offset / page * page;
+    len += offset - begin;
+    return ::madvise(const_cast<char *>(_data) + begin, len,
+                     _toMadvise(advice)) == 0;
+  }
+
+private:
+  static int _toMadvise(Advice advice) {
+    switch (advice) {
+    case Sequential:
+      return MADV_SEQUENTIAL;
+    case Random:
+      return MADV_RANDOM;
+    case WillNeed:
+      return MADV_WILLNEED;
+    default:
+      return MADV_NORMAL;
+    }
+  }
+
+  std::string _filename;
+  const char *_data;
+  size_t _size;
+};
+
+#endif // _MAPPED_FILE_HPP_
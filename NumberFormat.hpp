@@ -0,0 +1,166 @@
+#ifndef _NUMBER_FORMAT_HPP_
+#define _NUMBER_FORMAT_HPP_
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// locale independent number formatting into caller provided memory, built on
+// std::to_chars for floating point. Fixed mode matches printf("%.<p>f") and
+// shortest mode gives the shortest text that parses back to the same value.
+namespace NumberFormat {
+
+// longest "%.6f" text of a double, i.e., -DBL_MAX: sign, 309 integer
+// digits, point and 6 decimals
+constexpr size_t MaxFixed6 = 1 + 309 + 1 + 6;
+// longest shortest round trip text of a double, e.g., -2.2250738585072014e-308
+constexpr size_t MaxShortest = 24;
+// longest 64-bit integer with sign
+constexpr size_t MaxInt = 20;
+
+// "00" "01" ... "99"
+inline const char *digitPairs() {
+  static const char pairs[201] = "00010203040506070809"
+                                 "10111213141516171819"
+                                 "20212223242526272829"
+                                 "30313233343536373839"
+                                 "40414243444546474849"
+                                 "50515253545556575859"
+                                 "60616263646566676869"
+                                 "70717273747576777879"
+                                 "80818283848586878889"
+                                 "90919293949596979899";
+  return pairs;
+}
+
+inline unsigned countDigits(uint64_t v) {
+  unsigned n = 1;
+  for (;;) { // four digits per step
+    if (v < 10)
+      return n;
+    if (v < 100)
+      return n + 1;
+    if (v < 1000)
+      return n + 2;
+    if (v < 10000)
+      return n + 3;
+    v /= 10000;
+    n += 4;
+  }
+}
+
+// write <v> in decimal at <p>, two digits per division; returns the end
+template <typename T> char *formatInt(char *p, T v) {
+  static_assert(std::is_integral<T>::value, "integer expected");
+  using U = std::make_unsigned_t<T>;
+  U u = static_cast<U>(v);
+  if constexpr (std::is_signed<T>::value) {
+    if (v < 0) {
+      *p++ = '-';
+      u = static_cast<U>(0) - u;
+    }
+  }
+  uint64_t w = u;
+  char *end = p + countDigits(w);
+  char *q = end;
+  const char *pairs = digitPairs();
+  while (w >= 100) {
+    unsigned r = static_cast<unsigned>(w % 100);
+    w /= 100;
+    q -= 2;
+    std::memcpy(q, pairs + 2 * r, 2);
+  }
+  if (w >= 10) {
+    q -= 2;
+    std::memcpy(q, pairs + 2 * w, 2);
+  } else {
+    *--q = static_cast<char>('0' + w);
+  }
+  return end;
+}
+
+// printf("%.<precision>f") of <v> in [first, last); returns the end
+inline char *formatFixed(char *first, char *last, double v,
+                         int precision = 6) {
+  return std::to_chars(first, last, v, std::chars_format::fixed, precision)
+      .ptr;
+}
+
+// shortest text of <v> that parses back to <v> in [first, last); returns the
+// end
+inline char *formatShortest(char *first, char *last, double v) {
+  return std::to_chars(first, last, v).ptr;
+}
+} // namespace NumberFormat
+
+// growable character buffer that text is appended to and written out in one
+// go, e.g., a file or a line of results; reusing it avoids allocations
+class CharBuffer {
+public:
+  explicit CharBuffer(size_t capacity = 1u << 16) : _buf(capacity), _size(0) {}
+
+  const char *data() const { return _buf.data(); }
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  void clear() { _size = 0; }
+  std::string str() const { return std::string(_buf.data(), _size); }
+
+  CharBuffer &append(char c) {
+    _reserve(1);
+    _buf[_size++] = c;
+    return *this;
+  }
+  CharBuffer &append(const char *s, size_t len) {
+    _reserve(len);
+    std::memcpy(_buf.data() + _size, s, len);
+    _size += len;
+    return *this;
+  }
+  CharBuffer &append(const char *s) { return append(s, std::strlen(s)); }
+  CharBuffer &append(const std::string &s) {
+    return append(s.data(), s.size());
+  }
+
+  template <typename T> CharBuffer &appendInt(T v) {
+    _reserve(NumberFormat::MaxInt);
+    _size = NumberFormat::formatInt(_buf.data() + _size, v) - _buf.data();
+    return *this;
+  }
+  // same as printf("%.<precision>f")
+  CharBuffer &appendFixed(double v, int precision = 6) {
+    _reserve(NumberFormat::MaxFixed6 + (precision > 6 ? precision - 6 : 0));
+    char *end = _buf.data() + _buf.size();
+    _size = NumberFormat::formatFixed(_buf.data() + _size, end, v, precision) -
+            _buf.data();
+    return *this;
+  }
+  CharBuffer &appendShortest(double v) {
+    _reserve(NumberFormat::MaxShortest);
+    char *end = _buf.data() + _buf.size();
+    _size = NumberFormat::formatShortest(_buf.data() + _size, end, v) -
+            _buf.data();
+    return *this;
+  }
+
+  // write the content to <fp> and clear the buffer; returns false on errors
+  bool writeTo(FILE *fp) {
+    bool ok = _size == 0 || fwrite(_buf.data(), 1, _size, fp) == _size;
+    _size = 0;
+    return ok;
+  }
+
+private:
+  void _reserve(size_t n) {
+    if (_buf.size() - _size < n)
+      _buf.resize(std::max(2 * _buf.size(), _size + n));
+  }
+
+  std::vector<char> _buf;
+  size_t _size;
+};
+
+#endif // _NUMBER_FORMAT_HPP_
@@ -0,0 +1,117 @@
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Exception.h"
+#include "NumberFormat.hpp"
+#include "Timer.hpp"
+
+using namespace npp;
+
+// text of printf(<fmt>, v)
+template <typename T> std::string printed(const char *fmt, T v) {
+  char s[512];
+  snprintf(s, sizeof(s), fmt, v);
+  return s;
+}
+
+int main() {
+  try {
+    std::mt19937_64 gen(2020);
+    CharBuffer buf(16); // small to exercise growing
+
+    // integers, including the edge cases
+    for (int v : {0, 1, -1, 9, 10, 99, 100, -100, 123456789, INT_MAX, INT_MIN}) {
+      buf.clear();
+      NPP_ASSERT(buf.appendInt(v).str() == printed("%d", v));
+    }
+    for (uint64_t v : {uint64_t(0), uint64_t(9999), uint64_t(10000),
+                       uint64_t(UINT32_MAX), uint64_t(UINT64_MAX)}) {
+      buf.clear();
+      NPP_ASSERT(buf.appendInt(v).str() == printed("%lu", v));
+    }
+    buf.clear();
+    NPP_ASSERT(buf.appendInt(LLONG_MIN).str() == printed("%lld", LLONG_MIN));
+    for (int i = 0; i < 1000000; ++i) {
+      uint64_t u = gen() >> (gen() % 64);
+      int v = static_cast<int>(gen());
+      buf.clear();
+      NPP_ASSERT(buf.appendInt(u).str() == printed("%lu", u));
+      buf.clear();
+      NPP_ASSERT(buf.appendInt(v).str() == printed("%d", v));
+    }
+
+    // fixed mode is byte for byte "%.6f", also for halfway cases which are
+    // rounded by their exact binary value
+    for (double d : {0.0, -0.0, 0.5e-6, 1.5e-6, 2.5e-6, -2.5e-6, 0.0078125,
+                     1e-7, 0.1, 1.0 / 3, 123456.1234565, 0.9999995, 1e15,
+                     1e300, DBL_MAX, -DBL_MAX, DBL_MIN, DBL_TRUE_MIN}) {
+      buf.clear();
+      NPP_ASSERT(buf.appendFixed(d).str() == printed("%.6f", d));
+    }
+    std::uniform_real_distribution<double> reals(-1e4, 1e4);
+    for (int i = 0; i < 1000000; ++i) {
+      double d = reals(gen);
+      if (i % 4 == 0) // random bit patterns, any exponent
+        do {
+          uint64_t bits = gen();
+          std::memcpy(&d, &bits, sizeof(d));
+        } while (!std::isfinite(d));
+      buf.clear();
+      NPP_ASSERT(buf.appendFixed(d).str() == printed("%.6f", d));
+    }
+    buf.clear();
+    NPP_ASSERT(buf.appendFixed(M_PI, 12).str() == printed("%.12f", M_PI));
+
+    // shortest mode parses back to the same value
+    for (int i = 0; i < 1000000; ++i) {
+      double d;
+      do {
+        uint64_t bits = gen();
+        std::memcpy(&d, &bits, sizeof(d));
+      } while (!std::isfinite(d));
+      buf.clear();
+      buf.appendShortest(d);
+      NPP_ASSERT(buf.size() <= NumberFormat::MaxShortest);
+      NPP_ASSERT(std::strtod(buf.str().c_str(), nullptr) == d);
+    }
+    buf.clear();
+    NPP_ASSERT(buf.appendShortest(0.1).str() == "0.1");
+
+    // one line of mixed fields, as written by the result writers
+    buf.clear();
+    buf.appendInt(7).append(',').appendFixed(0.25).append(',').append("x");
+    buf.append('\n');
+    NPP_ASSERT(buf.str() == "7,0.250000,x\n");
+
+    // speed against printf for a typical result column
+    std::vector<double> values(1000000);
+    for (auto &v : values)
+      v = std::abs(reals(gen));
+    HighResolutionTimer timer;
+    timer.restart();
+    size_t total = 0;
+    char s[512];
+    for (double v : values)
+      total += snprintf(s, sizeof(s), "%.6f\n", v);
+    auto e1 = timer.elapsed();
+    timer.restart();
+    buf.clear();
+    for (double v : values)
+      buf.appendFixed(v).append('\n');
+    auto e2 = timer.elapsed();
+    NPP_ASSERT(buf.size() == total);
+    std::cout << "\"%.6f\" of " << values.size() << " values, snprintf: "
+              << e1 / 1000 << " ms, CharBuffer: " << e2 / 1000 << " ms"
+              << std::endl;
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
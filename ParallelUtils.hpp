@@ -0,0 +1,51 @@
+#ifndef _PARALLEL_UTILS_HPP_
+#define _PARALLEL_UTILS_HPP_
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace ParallelUtils {
+// number of threads to use when the caller passes 0
+inline unsigned defaultThreads() {
+  unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+// split [0, n) into at most <numThreads> contiguous ranges and call
+// fn(begin, end, threadId) for each of them concurrently; the first exception
+// thrown by any range is rethrown once all threads are joined
+template <typename Fn> void parallelFor(size_t n, unsigned numThreads, Fn fn) {
+  if (numThreads == 0)
+    numThreads = defaultThreads();
+  if (numThreads > n)
+    numThreads = static_cast<unsigned>(n);
+  if (numThreads <= 1) {
+    if (n > 0)
+      fn(size_t(0), n, 0u);
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(numThreads);
+  std::vector<std::thread> workers;
+  workers.reserve(numThreads);
+  size_t per = n / numThreads, extra = n % numThreads, begin = 0;
+  for (unsigned t = 0; t < numThreads; ++t) {
+    size_t end = begin + per + (t < extra ? 1 : 0);
+    workers.emplace_back([&fn, &errors, begin, end, t]() {
+      try {
+        fn(begin, end, t);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+    begin = end;
+  }
+  for (auto &w : workers)
+    w.join();
+  for (auto &e : errors)
+    if (e)
+      std::rethrow_exception(e);
+}
+} // namespace ParallelUtils
+
+#endif // _PARALLEL_UTILS_HPP_
@@ -0,0 +1,70 @@
+#ifndef _POSIX_FILE_HPP_
+#define _POSIX_FILE_HPP_
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// read-only file descriptor for positioned (thread safe) reads
+class PosixFile {
+public:
+  explicit PosixFile(const std::string &filename, int flags = 0)
+      : _filename(filename), _fd(-1), _size(0) {
+    _fd = ::open(_filename.c_str(), O_RDONLY | flags);
+    if (_fd < 0)
+      throw std::runtime_error("PosixFile::PosixFile(): Failed to open file " +
+                               _filename + ": " + std::strerror(errno));
+    struct stat st;
+    if (::fstat(_fd, &st) != 0) {
+      ::close(_fd);
+      throw std::runtime_error("PosixFile::PosixFile(): Failed to stat file " +
+                               _filename + ": " + std::strerror(errno));
+    }
+    _size = st.st_size;
+  }
+
+  PosixFile(const PosixFile &) = delete;
+  PosixFile &operator=(const PosixFile &) = delete;
+
+  ~PosixFile() {
+    if (_fd >= 0)
+      ::close(_fd);
+  }
+
+  int fd() const { return _fd; }
+  // total size in bytes
+  size_t size() const { return _size; }
+  const std::string &filename() const { return _filename; }
+
+  // read up to <len> bytes at <offset> into <buf>, retrying short reads;
+  // returns the number of bytes read which is less than <len> only at EOF
+  size_t pread(void *buf, size_t len, size_t offset) const {
+    char *dst = static_cast<char *>(buf);
+    size_t done = 0;
+    while (done < len) {
+      ssize_t r = ::pread(_fd, dst + done, len - done, offset + done);
+      if (r < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::runtime_error("PosixFile::pread(): Failed to read file " +
+                                 _filename + ": " + std::strerror(errno));
+      }
+      if (r == 0)
+        break; // EOF
+      done += r;
+    }
+    return done;
+  }
+
+private:
+  std::string _filename;
+  int _fd;
+  size_t _size;
+};
+
+#endif // _POSIX_FILE_HPP_
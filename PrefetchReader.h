@@ -0,0 +1,171 @@
+#ifndef _PREFETCH_READER_
+#define _PREFETCH_READER_
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "VecsReader.h"
+
+// streaming reader that keeps up to <queueDepth> chunks of <chunkPoints>
+// points read ahead by a background I/O thread, so reading the next chunk
+// overlaps with processing the current one. read(n)/read() have the same
+// semantics as in VecsReader.
+template <typename ElemT, typename OutT = ElemT> class PrefetchVecsReader {
+public:
+  PrefetchVecsReader(const char *filename, size_t chunkPoints = 1u << 16,
+                     size_t queueDepth = 2)
+      : _reader(filename), _chunk(chunkPoints), _depth(queueDepth),
+        _front_pos(0), _cur_pos(0), _stop(false), _done(false) {
+    VR_REQUIRED(chunkPoints > 0);
+    VR_REQUIRED(queueDepth > 0);
+    _start();
+  }
+  // noncopyable
+  PrefetchVecsReader(const PrefetchVecsReader &) = delete;
+  PrefetchVecsReader &operator=(const PrefetchVecsReader &) = delete;
+
+  ~PrefetchVecsReader() { _halt(); }
+
+  // get  data dimension
+  unsigned pointDimension() const { return _reader.pointDimension(); }
+  // total size in bytes
+  size_t size() const { return _reader.size(); }
+  // total number of points
+  size_t numPoints() const { return _reader.numPoints(); }
+  // number of points per prefetched chunk
+  size_t chunkPoints() const { return _chunk; }
+  // number of chunks read ahead
+  size_t queueDepth() const { return _depth; }
+
+  // read <n> points starting from current position
+  std::vector<OutT> read(size_t n) {
+    const unsigned dim = pointDimension();
+    if (n > numPoints() - _cur_pos)
+      n = numPoints() - _cur_pos;
+    std::vector<OutT> data;
+    data.reserve(n * dim);
+    while (n > 0) {
+      if (_front_pos * dim == _front.size() && !_nextChunk())
+        break; // I/O thread reached the end early
+      size_t avail = _front.size() / dim - _front_pos;
+      size_t take = (n < avail) ? n : avail;
+      auto first = _front.begin() + _front_pos * dim;
+      data.insert(data.end(), first, first + take * dim);
+      _front_pos += take;
+      _cur_pos += take;
+      n -= take;
+    }
+    return data;
+  }
+
+  // read all remaining points starting from current position
+  std::vector<OutT> read() {
+    auto n = numPoints() - _cur_pos;
+    if (n == 0)
+      return {};
+    return read(n);
+  }
+
+  // seek to the begining of the file
+  void rewind() {
+    _halt();
+    _queue.clear();
+    _front.clear();
+    _front_pos = 0;
+    _cur_pos = 0;
+    _error = nullptr;
+    _reader.rewind();
+    _start();
+  }
+
+private:
+  void _start() {
+    _stop = false;
+    _done = false;
+    _io = std::thread(&PrefetchVecsReader::_run, this);
+  }
+
+  // stop the I/O thread and wait for it
+  void _halt() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _not_full.notify_all();
+    if (_io.joinable())
+      _io.join();
+  }
+
+  // body of the I/O thread
+  void _run() {
+    try {
+      for (;;) {
+        {
+          std::unique_lock<std::mutex> lock(_mutex);
+          _not_full.wait(lock,
+                         [this] { return _stop || _queue.size() < _depth; });
+          if (_stop)
+            break;
+        }
+        auto chunk = _reader.read(_chunk);
+        bool last = chunk.size() < _chunk * pointDimension();
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if (!chunk.empty())
+            _queue.push_back(std::move(chunk));
+          _done = last;
+        }
+        _not_empty.notify_one();
+        if (last)
+          break;
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _error = std::current_exception();
+      _done = true;
+    }
+    _not_empty.notify_one();
+  }
+
+  // replace the consumed front chunk with the next prefetched one
+  bool _nextChunk() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _not_empty.wait(lock, [this] { return !_queue.empty() || _done; });
+    if (_queue.empty()) {
+      if (_error)
+        std::rethrow_exception(_error);
+      return false;
+    }
+    _front = std::move(_queue.front());
+    _queue.pop_front();
+    _front_pos = 0;
+    lock.unlock();
+    _not_full.notify_one();
+    return true;
+  }
+
+  VecsReader<ElemT, OutT> _reader; // only used by the I/O thread once started
+  size_t _chunk;                   // points per chunk
+  size_t _depth;                   // max number of chunks read ahead
+  std::vector<OutT> _front;        // chunk being consumed
+  size_t _front_pos;               // consumed points of <_front>
+  size_t _cur_pos;                 // current position (in points not bytes)
+
+  std::thread _io;
+  std::mutex _mutex;
+  std::condition_variable _not_full;
+  std::condition_variable _not_empty;
+  std::deque<std::vector<OutT>> _queue; // prefetched chunks
+  bool _stop;
+  bool _done;
+  std::exception_ptr _error;
+};
+
+using PrefetchFvecsReader = PrefetchVecsReader<float>;
+using PrefetchBvecsReader = PrefetchVecsReader<uint8_t>;
+using PrefetchIvecsReader = PrefetchVecsReader<int>;
+
+#endif // _PREFETCH_READER_
@@ -0,0 +1,48 @@
+#include <iostream>
+#include "Exception.h"
+#include "PrefetchReader.h"
+
+using namespace npp;
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+const char *FVF = "./sample-data/gist_query.fvecs";
+
+template <typename ElemT, typename OutT>
+void checkPrefetch(const char *filename, size_t chunk, size_t depth) {
+  VecsReader<ElemT, OutT> reader(filename);
+  PrefetchVecsReader<ElemT, OutT> prefetch(filename, chunk, depth);
+  NPP_ASSERT(prefetch.numPoints() == reader.numPoints());
+  NPP_ASSERT(prefetch.pointDimension() == reader.pointDimension());
+
+  for (size_t n : {1, 3, 10, 64, 100}) {
+    auto expect = reader.read(n);
+    auto got = prefetch.read(n);
+    NPP_ASSERT(expect == got);
+  }
+  NPP_ASSERT(prefetch.read() == reader.read());
+  NPP_ASSERT(prefetch.read().empty());
+  NPP_ASSERT(prefetch.read(5).empty());
+
+  prefetch.rewind();
+  reader.rewind();
+  NPP_ASSERT(prefetch.read(7) == reader.read(7));
+  NPP_ASSERT(prefetch.read() == reader.read());
+}
+
+int main() {
+  try {
+    checkPrefetch<uint8_t, uint8_t>(BVF, 7, 1);
+    checkPrefetch<uint8_t, float>(BVF, 1000, 2);
+    checkPrefetch<uint8_t, uint8_t>(BVF, 1u << 16, 4);
+    checkPrefetch<float, float>(FVF, 50, 3);
+    {
+      // destroy while the I/O thread is still reading ahead
+      PrefetchBvecsReader prefetch(BVF, 1, 2);
+      NPP_ASSERT(prefetch.read(1).size() == prefetch.pointDimension());
+    }
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
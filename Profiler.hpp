@@ -0,0 +1,247 @@
+#ifndef _PROFILER_HPP_
+#define _PROFILER_HPP_
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Timer.hpp"
+
+// hierarchical profiler of scoped zones, e.g.,
+//
+//   void search() {
+//     PROFILE_ZONE("search");
+//     { PROFILE_ZONE("distance"); ... }
+//     { PROFILE_ZONE("top-k"); ... }
+//   }
+//
+// Each thread accumulates count/total/min/max of its zones in its own tree,
+// keyed by the nesting of the zones, without locks; Profiler::text() and
+// Profiler::json() merge the trees of all threads by path. Reports are meant
+// for when the profiled threads are done, e.g., at exit. Building with
+// -DDISABLE_PROFILE removes the zones entirely.
+namespace Profiler {
+
+struct Node {
+  const char *name;
+  size_t parent;
+  std::vector<size_t> children;
+  uint64_t count = 0;
+  double total = 0; // microseconds
+  double min = 0;
+  double max = 0;
+
+  Node(const char *name, size_t parent) : name(name), parent(parent) {}
+
+  void add(double us) {
+    if (count == 0 || us < min)
+      min = us;
+    if (us > max)
+      max = us;
+    total += us;
+    ++count;
+  }
+  void merge(const Node &other) {
+    if (other.count == 0)
+      return;
+    if (count == 0 || other.min < min)
+      min = other.min;
+    if (other.max > max)
+      max = other.max;
+    total += other.total;
+    count += other.count;
+  }
+};
+
+// zone tree of one thread, node 0 is the root
+class Tree {
+public:
+  Tree() : _cur(0) { _nodes.emplace_back("", 0); }
+
+  // enter the child zone <name> of the current zone
+  size_t enter(const char *name) {
+    for (size_t c : _nodes[_cur].children) // names are usually literals
+      if (_nodes[c].name == name || std::strcmp(_nodes[c].name, name) == 0)
+        return _cur = c;
+    _nodes.emplace_back(name, _cur);
+    _nodes[_cur].children.push_back(_nodes.size() - 1);
+    return _cur = _nodes.size() - 1;
+  }
+  void leave(size_t node, double us) {
+    _nodes[node].add(us);
+    _cur = _nodes[node].parent;
+  }
+
+  // add the zones of <other> below the same paths
+  void merge(const Tree &other, size_t from = 0, size_t to = 0) {
+    for (size_t c : other._nodes[from].children) {
+      size_t saved = _cur;
+      _cur = to;
+      size_t n = enter(other._nodes[c].name);
+      _cur = saved;
+      _nodes[n].merge(other._nodes[c]);
+      merge(other, c, n);
+    }
+  }
+
+  const std::vector<Node> &nodes() const { return _nodes; }
+  void clear() {
+    _nodes.erase(_nodes.begin() + 1, _nodes.end());
+    _nodes[0].children.clear();
+    _cur = 0;
+  }
+
+private:
+  std::vector<Node> _nodes;
+  size_t _cur; // innermost open zone
+};
+
+// trees of all threads that entered a zone, owned here so they outlive
+// their threads
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Tree>> trees;
+
+  static Registry &instance() {
+    static Registry r;
+    return r;
+  }
+};
+
+inline Tree &threadTree() {
+  thread_local Tree *tree = nullptr;
+  if (tree == nullptr) { // first zone of this thread
+    auto &r = Registry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.trees.emplace_back(new Tree());
+    tree = r.trees.back().get();
+  }
+  return *tree;
+}
+
+// RAII zone, see PROFILE_ZONE
+class Zone {
+public:
+  explicit Zone(const char *name)
+      : _tree(threadTree()), _node(_tree.enter(name)) {
+    _timer.restart();
+  }
+  ~Zone() { _tree.leave(_node, _timer.elapsed()); }
+
+  Zone(const Zone &) = delete;
+  Zone &operator=(const Zone &) = delete;
+
+private:
+  Tree &_tree;
+  size_t _node;
+  RdtscTimer _timer;
+};
+
+// zones of all threads
+inline Tree merged() {
+  Tree all;
+  auto &r = Registry::instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (const auto &t : r.trees)
+    all.merge(*t);
+  return all;
+}
+
+// forget the zones measured so far, no zone may be open
+inline void reset() {
+  auto &r = Registry::instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (auto &t : r.trees)
+    t->clear();
+}
+
+inline void _text(const Tree &tree, size_t node, int depth, std::string &out) {
+  const auto &nodes = tree.nodes();
+  for (size_t c : nodes[node].children) {
+    const Node &n = nodes[c];
+    char line[512];
+    double parent = node == 0 ? 0 : nodes[node].total;
+    snprintf(line, sizeof(line),
+             "%*s%-*s %10llu %12.3f %10.3f %10.3f %10.3f %6.1f%%\n",
+             2 * depth, "", 32 - 2 * depth, n.name,
+             static_cast<unsigned long long>(n.count), n.total / 1000,
+             n.total / n.count, n.min, n.max,
+             parent > 0 ? 100 * n.total / parent : 100.0);
+    out += line;
+    _text(tree, c, depth + 1, out);
+  }
+}
+
+// indented table of the zones; times in microseconds except the total and
+// the share of the parent zone
+inline std::string text() {
+  std::string out;
+  char line[256];
+  snprintf(line, sizeof(line), "%-32s %10s %12s %10s %10s %10s %7s\n", "zone",
+           "count", "total(ms)", "mean(us)", "min(us)", "max(us)", "parent");
+  out += line;
+  _text(merged(), 0, 0, out);
+  return out;
+}
+
+inline void _json(const Tree &tree, size_t node, std::string &out) {
+  const auto &nodes = tree.nodes();
+  out += '[';
+  for (size_t i = 0; i < nodes[node].children.size(); ++i) {
+    const Node &n = nodes[nodes[node].children[i]];
+    char fields[256];
+    snprintf(fields, sizeof(fields),
+             "\"count\":%llu,\"total_us\":%.3f,\"min_us\":%.3f,"
+             "\"max_us\":%.3f,\"children\":",
+             static_cast<unsigned long long>(n.count), n.total, n.min, n.max);
+    out += (i == 0 ? "" : ",");
+    out += "{\"name\":\"";
+    for (const char *p = n.name; *p; ++p) { // escape quotes and backslashes
+      if (*p == '"' || *p == '\\')
+        out += '\\';
+      out += *p;
+    }
+    out += "\",";
+    out += fields;
+    _json(tree, nodes[node].children[i], out);
+    out += '}';
+  }
+  out += ']';
+}
+
+// the zone tree as a JSON array of {name, count, total_us, min_us, max_us,
+// children}
+inline std::string json() {
+  std::string out;
+  _json(merged(), 0, out);
+  return out;
+}
+
+// print text() or json() to stderr when the program exits
+inline void reportAtExit(bool asJson = false) {
+  // the registry must outlive the hook, i.e., be constructed before it is
+  // registered, as static objects are destroyed in reverse order
+  Registry::instance();
+  if (asJson)
+    std::atexit([] { fprintf(stderr, "%s\n", json().c_str()); });
+  else
+    std::atexit([] { fprintf(stderr, "%s", text().c_str()); });
+}
+} // namespace Profiler
+
+#define _PROFILE_CONCAT2(a, b) a##b
+#define _PROFILE_CONCAT(a, b) _PROFILE_CONCAT2(a, b)
+#ifdef DISABLE_PROFILE
+#define PROFILE_ZONE(name) ((void)0)
+#else
+// time the rest of the enclosing scope as the zone <name>, a string that
+// lives as long as the program, e.g., a literal
+#define PROFILE_ZONE(name)                                                     \
+  Profiler::Zone _PROFILE_CONCAT(_profile_zone_, __LINE__)(name)
+#endif
+
+#endif // _PROFILER_HPP_
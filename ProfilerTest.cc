@@ -0,0 +1,92 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Exception.h"
+#include "Profiler.hpp"
+
+using namespace npp;
+
+void work(unsigned us) {
+  RdtscTimer timer;
+  timer.restart();
+  while (timer.elapsed() < us)
+    ;
+}
+
+void query() {
+  PROFILE_ZONE("query");
+  {
+    PROFILE_ZONE("distance");
+    work(20);
+  }
+  {
+    PROFILE_ZONE("top-k");
+    work(5);
+  }
+}
+
+// node below the root at <path>, nullptr if missing
+const Profiler::Node *find(const Profiler::Tree &tree,
+                           std::vector<std::string> path) {
+  size_t cur = 0;
+  for (const auto &name : path) {
+    size_t next = 0;
+    for (size_t c : tree.nodes()[cur].children)
+      if (tree.nodes()[c].name == name)
+        next = c;
+    if (next == 0)
+      return nullptr;
+    cur = next;
+  }
+  return &tree.nodes()[cur];
+}
+
+int main() {
+  try {
+    // before the first zone, as at the top of main()
+    Profiler::reportAtExit(true);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t)
+      workers.emplace_back([]() {
+        for (int i = 0; i < 100; ++i)
+          query();
+      });
+    for (int i = 0; i < 50; ++i)
+      query();
+    {
+      PROFILE_ZONE("write");
+      static char name[] = "query"; // same name, another pointer
+      Profiler::Zone nested(name);
+    }
+    for (auto &w : workers)
+      w.join();
+
+    auto tree = Profiler::merged();
+    auto q = find(tree, {"query"});
+    auto d = find(tree, {"query", "distance"});
+    auto k = find(tree, {"query", "top-k"});
+    NPP_ASSERT(q && d && k && find(tree, {"write", "query"}));
+    NPP_ASSERT(!find(tree, {"distance"}));
+    NPP_ASSERT(q->count == 450 && d->count == 450 && k->count == 450);
+    NPP_ASSERT(d->min >= 20 && d->max >= d->min && d->total >= 450 * 20);
+    NPP_ASSERT(q->total >= d->total + k->total);
+
+    auto text = Profiler::text();
+    auto json = Profiler::json();
+    std::cout << text << json << std::endl;
+    NPP_ASSERT(text.find("\n  distance") != std::string::npos);
+    NPP_ASSERT(json.compare(0, 25, "[{\"name\":\"query\",\"count\":") == 0);
+    NPP_ASSERT(json.find("\"children\":[{\"name\":\"distance\"") !=
+               std::string::npos);
+
+    Profiler::reset();
+    NPP_ASSERT(Profiler::json() == "[]");
+    PROFILE_ZONE("exit"); // in the report at exit
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#ifndef _SHARDED_READER_
+#define _SHARDED_READER_
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "Span.hpp"
+#include "VecsReader.h"
+#include "VecsView.hpp"
+
+// reader confined to the <shardId>-th of <numShards> even, point-aligned
+// slices of a vecs file, so that each worker thread or process can open its
+// own shard independently. Point ids are local to the shard, add
+// globalOffset() to get the ids in the whole file.
+template <typename ElemT, typename OutT = ElemT> class ShardedReader {
+public:
+  ShardedReader(const char *filename, size_t shardId, size_t numShards)
+      : _reader(filename), _shard(shardId), _num_shards(numShards),
+        _cur_pos(0) {
+    VR_REQUIRED(numShards > 0);
+    VR_REQUIRED(shardId < numShards);
+    auto range = shardRange(_reader.numPoints(), shardId, numShards);
+    _begin = range.first;
+    _n = range.second - range.first;
+  }
+  // noncopyable
+  ShardedReader(const ShardedReader &) = delete;
+  ShardedReader &operator=(const ShardedReader &) = delete;
+
+  // [first, last) point ids of the <shardId>-th of <numShards> slices of
+  // <n> points, the first n % numShards shards get one extra point
+  static std::pair<size_t, size_t> shardRange(size_t n, size_t shardId,
+                                              size_t numShards) {
+    size_t each = n / numShards, extra = n % numShards;
+    size_t first = shardId * each + std::min(shardId, extra);
+    return {first, first + each + (shardId < extra ? 1 : 0)};
+  }
+
+  // get  data dimension
+  unsigned pointDimension() const { return _reader.pointDimension(); }
+  // number of points in this shard
+  size_t numPoints() const { return _n; }
+  // number of points in the whole file
+  size_t totalPoints() const { return _reader.numPoints(); }
+  // global id of the first point of this shard
+  size_t globalOffset() const { return _begin; }
+  size_t shardId() const { return _shard; }
+  size_t numShards() const { return _num_shards; }
+  // underlying reader of the whole file
+  VecsReader<ElemT, OutT> &reader() { return _reader; }
+
+  // read from a-th point (including) until b-th point (not including) of
+  // this shard
+  template <typename T = OutT> std::vector<T> read(size_t a, size_t b) {
+    VR_REQUIRED(b > a);
+    if (a >= _n)
+      return {};
+    if (b > _n)
+      b = _n;
+    return _reader.template read<T>(_begin + a, _begin + b);
+  }
+
+  // read <n> points starting from current position
+  template <typename T = OutT> std::vector<T> read(size_t n) {
+    if (n > _n - _cur_pos)
+      n = _n - _cur_pos;
+    if (n == 0)
+      return {};
+    auto data = read<T>(_cur_pos, _cur_pos + n);
+    _cur_pos += data.size() / pointDimension();
+    return data;
+  }
+
+  // read all remaining points of this shard starting from current position
+  template <typename T = OutT> std::vector<T> read() {
+    return read<T>(_n - _cur_pos);
+  }
+
+  // read the next (at most) <chunkPoints> points into <buf>, reusing its
+  // memory; returns a view of them, which is empty at the end of the shard
+  template <typename T = OutT>
+  VecsView<T> nextChunk(size_t chunkPoints, std::vector<T> &buf) {
+    VR_REQUIRED(chunkPoints > 0);
+    const unsigned dim = pointDimension();
+    size_t n = std::min(chunkPoints, _n - _cur_pos);
+    if (n == 0)
+      return {};
+    if (buf.size() < n * dim)
+      buf.resize(chunkPoints * dim);
+    n = _reader.readInto(Span<T>(buf), _begin + _cur_pos,
+                         _begin + _cur_pos + n);
+    _cur_pos += n;
+    return VecsView<T>(buf.data(), n, dim, dim);
+  }
+
+  // call fn(globalId, chunk) for consecutive chunks of <chunkPoints> points
+  // from the current position to the end of the shard, where <globalId> is
+  // the id of the first point of <chunk> in the whole file
+  template <typename T = OutT, typename Fn>
+  void forEachChunk(size_t chunkPoints, Fn fn) {
+    std::vector<T> buf;
+    for (;;) {
+      size_t first = _begin + _cur_pos;
+      auto chunk = nextChunk<T>(chunkPoints, buf);
+      if (chunk.empty())
+        break;
+      fn(first, chunk);
+    }
+  }
+
+  // seek to the begining of the shard
+  void rewind() { _cur_pos = 0; }
+
+private:
+  VecsReader<ElemT, OutT> _reader;
+  size_t _shard;
+  size_t _num_shards;
+  size_t _begin;
+  size_t _n;
+  size_t _cur_pos;
+};
+
+using ShardedFvecsReader = ShardedReader<float>;
+using ShardedBvecsReader = ShardedReader<uint8_t>;
+using ShardedIvecsReader = ShardedReader<int>;
+
+#endif // _SHARDED_READER_
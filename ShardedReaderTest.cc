@@ -0,0 +1,104 @@
+#include <iostream>
+#include <thread>
+#include "Exception.h"
+#include "ShardedReader.h"
+
+using namespace npp;
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+const char *FVF = "./sample-data/gist_query.fvecs";
+
+template <typename ElemT, typename OutT>
+void checkShards(const char *filename, size_t numShards, size_t chunk) {
+  VecsReader<ElemT, OutT> whole(filename);
+  auto all = whole.read();
+  const unsigned dim = whole.pointDimension();
+
+  // one worker thread per shard, each with its own reader
+  std::vector<std::vector<OutT>> parts(numShards);
+  std::vector<size_t> offsets(numShards), counts(numShards);
+  std::vector<char> ordered(numShards, 1);
+  std::vector<std::thread> workers;
+  for (size_t s = 0; s < numShards; ++s) {
+    workers.emplace_back([&, s]() {
+      ShardedReader<ElemT, OutT> shard(filename, s, numShards);
+      offsets[s] = shard.globalOffset();
+      counts[s] = shard.numPoints();
+      shard.template forEachChunk<OutT>(
+          chunk, [&](size_t first, VecsView<OutT> v) {
+            if (first != offsets[s] + parts[s].size() / dim)
+              ordered[s] = 0; // global ids of the chunks must be consecutive
+            parts[s].insert(parts[s].end(), v.data(),
+                            v.data() + v.numPoints() * dim);
+          });
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+
+  size_t next = 0;
+  std::vector<OutT> joined;
+  for (size_t s = 0; s < numShards; ++s) {
+    NPP_ASSERT(ordered[s]);
+    NPP_ASSERT(offsets[s] == next); // contiguous, in order
+    NPP_ASSERT(parts[s].size() == counts[s] * dim);
+    // even split
+    NPP_ASSERT(counts[s] == whole.numPoints() / numShards ||
+               counts[s] == whole.numPoints() / numShards + 1);
+    next += counts[s];
+    joined.insert(joined.end(), parts[s].begin(), parts[s].end());
+  }
+  NPP_ASSERT(next == whole.numPoints());
+  NPP_ASSERT(joined == all);
+}
+
+int main() {
+  try {
+    checkShards<uint8_t, uint8_t>(BVF, 1, 1000);
+    checkShards<uint8_t, float>(BVF, 3, 777);
+    checkShards<uint8_t, uint8_t>(BVF, 7, 1u << 16);
+    checkShards<float, float>(FVF, 4, 33);
+
+    {
+      BvecsReader whole(BVF);
+      ShardedBvecsReader shard(BVF, 2, 3);
+      NPP_ASSERT(shard.totalPoints() == whole.numPoints());
+      const size_t off = shard.globalOffset();
+      NPP_ASSERT(off == 2 * (whole.numPoints() / 3) +
+                            std::min<size_t>(2, whole.numPoints() % 3));
+      // local ids, clipped at the end of the shard
+      NPP_ASSERT(shard.read(5, 10) == whole.read(off + 5, off + 10));
+      NPP_ASSERT(shard.read(shard.numPoints() - 2, shard.numPoints() + 100) ==
+                 whole.read(off + shard.numPoints() - 2, whole.numPoints()));
+      NPP_ASSERT(shard.read(shard.numPoints(), shard.numPoints() + 1).empty());
+
+      // streaming reads stay inside the shard
+      NPP_ASSERT(shard.read(3) == whole.read(off, off + 3));
+      NPP_ASSERT(shard.read() == whole.read(off + 3, whole.numPoints()));
+      NPP_ASSERT(shard.read().empty());
+      std::vector<uint8_t> buf;
+      NPP_ASSERT(shard.nextChunk(10, buf).empty());
+      shard.rewind();
+      auto chunk = shard.nextChunk(10, buf);
+      NPP_ASSERT(chunk.numPoints() == 10);
+      auto expect = whole.read(off, off + 10);
+      NPP_ASSERT(std::equal(expect.begin(), expect.end(), chunk.data()));
+
+      // more shards than points leaves some of them empty
+      ShardedBvecsReader tiny(BVF, whole.numPoints(), whole.numPoints() + 1);
+      NPP_ASSERT(tiny.numPoints() == 0 && tiny.read().empty());
+    }
+
+    bool thrown = false;
+    try {
+      ShardedBvecsReader bad(BVF, 3, 3);
+    } catch (const VecsReaderException &) {
+      thrown = true;
+    }
+    NPP_ASSERT(thrown);
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#ifndef _SPAN_HPP_
+#define _SPAN_HPP_
+#include <cstddef>
+#include <vector>
+
+// non-owning view of contiguous memory, a minimal stand-in for C++20 std::span
+template <typename T> class Span {
+public:
+  Span() : _data(nullptr), _size(0) {}
+  Span(T *data, size_t size) : _data(data), _size(size) {}
+  template <typename U, typename A>
+  Span(std::vector<U, A> &v) : _data(v.data()), _size(v.size()) {}
+  template <typename U, typename A>
+  Span(const std::vector<U, A> &v) : _data(v.data()), _size(v.size()) {}
+
+  T *data() const { return _data; }
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  T *begin() const { return _data; }
+  T *end() const { return _data + _size; }
+  T &operator[](size_t i) const { return _data[i]; }
+
+  // elements [offset, offset + count)
+  Span subspan(size_t offset, size_t count) const {
+    return Span(_data + offset, count);
+  }
+
+private:
+  T *_data;
+  size_t _size;
+};
+
+#endif // _SPAN_HPP_
@@ -2,6 +2,13 @@
 #define __TIMER_HPP_
 
 #include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define NPP_HAS_TSC 1
+#endif
 
 using namespace std::chrono;
 struct HighResolutionTimer {
@@ -18,4 +25,130 @@ private:
   high_resolution_clock::time_point _start;
 };
 
+// time stamp counter of the CPU: reading it costs a few nanoseconds instead
+// of a clock_gettime() call. Its rate is calibrated once against
+// steady_clock; without an invariant TSC (constant rate in all power states)
+// the ticks are steady_clock nanoseconds instead.
+namespace Tsc {
+
+// whether the CPU has an invariant TSC (CPUID 0x80000007, EDX bit 8)
+inline bool invariant() {
+#ifdef NPP_HAS_TSC
+  unsigned eax, ebx, ecx, edx;
+  if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 ||
+      eax < 0x80000007)
+    return false;
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx >> 8) & 1;
+#else
+  return false;
+#endif
+}
+
+inline uint64_t _steadyNs() {
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// tick at the start of a measured region: the fence keeps the measured
+// instructions from starting before the read (earlier ones may still be
+// retiring, which only costs a few cycles of precision)
+inline uint64_t _startTick(bool tsc) {
+#ifdef NPP_HAS_TSC
+  if (tsc) {
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+  }
+#endif
+  return _steadyNs();
+}
+
+// tick at the end of a measured region: rdtscp waits for all earlier
+// instructions; no fence after it, later instructions do not matter
+inline uint64_t _stopTick(bool tsc) {
+#ifdef NPP_HAS_TSC
+  if (tsc) {
+    unsigned aux;
+    return __rdtscp(&aux);
+  }
+#endif
+  return _steadyNs();
+}
+
+struct Calibration {
+  bool tsc;          // false if ticks are steady_clock nanoseconds
+  double ticksPerUs; // tick rate
+  double usPerTick;  // its inverse, to convert with a multiplication
+  double overheadUs; // cost of an empty restart()/elapsed() pair
+};
+
+inline Calibration _calibrate() {
+  Calibration c;
+  c.tsc = invariant();
+  c.ticksPerUs = 1000;
+  if (c.tsc) { // 20ms against steady_clock
+    auto t0 = steady_clock::now();
+    uint64_t c0 = _startTick(true);
+    auto t1 = t0;
+    while (t1 - t0 < milliseconds(20))
+      t1 = steady_clock::now();
+    uint64_t c1 = _stopTick(true);
+    c.ticksPerUs = (c1 - c0) / duration<double, std::micro>(t1 - t0).count();
+  }
+  c.usPerTick = 1 / c.ticksPerUs;
+  uint64_t best = UINT64_MAX;
+  for (int i = 0; i < 1000; ++i) {
+    uint64_t t = _startTick(c.tsc);
+    uint64_t d = _stopTick(c.tsc) - t;
+    if (d < best)
+      best = d;
+  }
+  c.overheadUs = best * c.usPerTick;
+  return c;
+}
+
+// measured on first use
+inline const Calibration &calibration() {
+  static const Calibration c = _calibrate();
+  return c;
+}
+} // namespace Tsc
+
+// drop-in replacement of HighResolutionTimer for short regions, e.g.,
+// per-query times of microsecond searches; elapsed() includes the overhead of
+// the timer itself, which callers may subtract. Hot loops can keep the raw
+// elapsedTicks() and convert them with toUs() later.
+struct RdtscTimer {
+  RdtscTimer() : _cal(&Tsc::calibration()), _start(0) {}
+
+  void restart() { _start = Tsc::_startTick(_cal->tsc); }
+
+  // microseconds since restart()
+  double elapsed() const { return toUs(elapsedTicks()); }
+
+  // ticks since restart(), i.e., TSC cycles or nanoseconds
+  uint64_t elapsedTicks() const { return Tsc::_stopTick(_cal->tsc) - _start; }
+  double toUs(uint64_t ticks) const { return ticks * _cal->usPerTick; }
+
+  // whether the TSC is used instead of steady_clock
+  static bool usesTsc() { return Tsc::calibration().tsc; }
+  // microseconds of an empty restart()/elapsed() pair
+  static double overhead() { return Tsc::calibration().overheadUs; }
+
+private:
+  const Tsc::Calibration *_cal;
+  uint64_t _start;
+};
+
+// record the nanoseconds elapsed on <timer>, a HighResolutionTimer or an
+// RdtscTimer, into <hist>, e.g., a LatencyHistogram, and return the elapsed
+// microseconds
+template <typename Timer, typename Histogram>
+double recordElapsed(const Timer &timer, Histogram &hist) {
+  double us = timer.elapsed();
+  hist.record(us > 0 ? static_cast<uint64_t>(us * 1000 + 0.5) : 0);
+  return us;
+}
+
 #endif // __TIMER_HPP_
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "Timer.hpp"
+#include <cassert>
+#include <cmath>
 #include <iostream>
 #include <thread>
 
@@ -16,5 +18,46 @@ int main() {
 
   fprintf(stdout, "exec time: %.6f us\n", el);
 
+  // the TSC timer agrees with the clock
+  RdtscTimer tsc;
+  tsc.restart();
+  timer.restart();
+  std::this_thread::sleep_for(100ms);
+  auto el2 = timer.elapsed();
+  auto ticks = tsc.elapsedTicks();
+  auto el3 = tsc.toUs(ticks);
+  fprintf(stdout, "exec time: %.6f us (rdtsc: %.6f us, %s)\n", el2, el3,
+          RdtscTimer::usesTsc() ? "invariant TSC" : "steady_clock fallback");
+  assert(std::abs(el3 - el2) < 0.01 * el2);
+
+  // cost of a restart()/elapsed() pair of both timers, which depends on the
+  // CPU and on the hypervisor, e.g., a trapped or slow RDTSC
+  const int n = 1000000;
+  volatile double sum = 0; // keep the loops
+  timer.restart();
+  for (int i = 0; i < n; ++i) {
+    tsc.restart();
+    sum += tsc.elapsed();
+  }
+  auto perTsc = timer.elapsed() * 1000 / n;
+  volatile uint64_t ticksSum = 0;
+  timer.restart();
+  for (int i = 0; i < n; ++i) {
+    tsc.restart();
+    ticksSum += tsc.elapsedTicks();
+  }
+  auto perTicks = timer.elapsed() * 1000 / n;
+  HighResolutionTimer hr;
+  timer.restart();
+  for (int i = 0; i < n; ++i) {
+    hr.restart();
+    sum += hr.elapsed();
+  }
+  auto perHr = timer.elapsed() * 1000 / n;
+  fprintf(stdout,
+          "restart()+elapsed(): rdtsc %.1f ns (%.1f ns with elapsedTicks()), "
+          "high_resolution_clock %.1f ns; overhead constant %.1f ns\n",
+          perTsc, perTicks, perHr, RdtscTimer::overhead() * 1000);
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+#ifndef __TYPED_ANNRESULT_HPP__
+#define __TYPED_ANNRESULT_HPP__
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Exception.h"
+#include "NumberFormat.hpp"
+#include "Span.hpp"
+
+namespace AnnResults {
+
+// column types of TypedAnnResultWriter and the AnnResultWriter format
+// characters they replace: integers ('i'), floating point ('f'/'d', printed
+// as "%.6f"), char ('c') and strings ('s')
+template <typename T> struct IsColumn {
+  static constexpr bool value =
+      (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value) ||
+      std::is_same<T, const char *>::value ||
+      std::is_same<T, std::string>::value;
+};
+} // namespace AnnResults
+
+// writer of comma separated rows with the column types fixed at compile time,
+// so a row with the wrong number or types of values does not compile. Fields
+// are formatted with NumberFormat into a CharBuffer written with one fwrite
+// once it holds <bufferSize> bytes; the text is the same as
+// AnnResultWriter::writeRow() with the matching format.
+template <typename... Cols> class TypedAnnResultWriter {
+  static_assert(sizeof...(Cols) > 0, "at least one column is required");
+  static_assert((AnnResults::IsColumn<Cols>::value && ...),
+                "unsupported column type");
+
+public:
+  using Row = std::tuple<Cols...>;
+  static constexpr size_t NumColumns = sizeof...(Cols);
+
+  TypedAnnResultWriter(const std::string &filename,
+                       bool allowOverwrite = false,
+                       size_t bufferSize = 1u << 20)
+      : _fp(nullptr), _filename_cp(filename),
+        _buf(bufferSize + 4096), _flush_size(bufferSize), _ok(true) {
+    if (!allowOverwrite && _exists()) {
+      throw npp::Exception("TypedAnnResultWriter::TypedAnnResultWriter(): "
+                           "file " +
+                               _filename_cp + " already exists",
+                           __FILE__, __LINE__);
+    }
+    if ((_fp = fopen(_filename_cp.c_str(), "w")) == nullptr)
+      throw std::runtime_error(
+          "TypedAnnResultWriter::TypedAnnResultWriter(): Failed to open file " +
+          _filename_cp);
+  }
+
+  TypedAnnResultWriter(const TypedAnnResultWriter &) = delete;
+  TypedAnnResultWriter &operator=(const TypedAnnResultWriter &) = delete;
+
+  ~TypedAnnResultWriter() {
+    if (_fp) {
+      flush();
+      fclose(_fp);
+    }
+  }
+
+  // a line of text, e.g., AnnResults::_DEFAULT_HEADER_E_
+  bool writeHeader(const char *header) {
+    _buf.append(header).append('\n');
+    return _maybeFlush();
+  }
+
+  bool writeRow(const Cols &...vals) {
+    size_t col = 0;
+    (_writeField(vals, col++ == 0), ...);
+    _buf.append('\n');
+    return _maybeFlush();
+  }
+
+  bool writeRow(const Row &row) {
+    return std::apply([this](const Cols &...vals) { return writeRow(vals...); },
+                      row);
+  }
+
+  bool writeRows(Span<const Row> rows) {
+    for (const auto &row : rows)
+      writeRow(row);
+    return _ok;
+  }
+
+  // write the buffered text to the file
+  bool flush() {
+    if (!_buf.writeTo(_fp) || fflush(_fp) != 0)
+      _fail();
+    return _ok;
+  }
+
+private:
+  bool _maybeFlush() { return _buf.size() >= _flush_size ? flush() : _ok; }
+
+  template <typename T> void _writeField(const T &val, bool isFirst) {
+    if (!isFirst)
+      _buf.append(',');
+    if constexpr (std::is_same<T, const char *>::value ||
+                  std::is_same<T, std::string>::value ||
+                  std::is_same<T, char>::value)
+      _buf.append(val);
+    else if constexpr (std::is_floating_point<T>::value)
+      _buf.appendFixed(static_cast<double>(val), 6);
+    else
+      _buf.appendInt(val);
+  }
+
+  void _fail() {
+#ifdef DEBUG
+    if (_ok)
+      perror("TypedAnnResultWriter::flush() failed.\nError: ");
+#endif
+    _ok = false;
+  }
+
+  bool _exists() const {
+    FILE *fp = fopen(_filename_cp.c_str(), "r");
+    bool ex = (fp != nullptr);
+    if (ex)
+      fclose(fp);
+
+    return ex;
+  }
+  FILE *_fp;
+  std::string _filename_cp;
+  CharBuffer _buf;
+  size_t _flush_size;
+  bool _ok;
+};
+
+namespace AnnResults {
+// typed writers of the _DEFAULT_FMT_E_ ("iiiiiffi") and _DEFAULT_FMT_I_
+// ("iiiiiff") columns
+using DefaultWriterE =
+    TypedAnnResultWriter<int, int, int, int, int, double, double, int>;
+using DefaultWriterI =
+    TypedAnnResultWriter<int, int, int, int, int, double, double>;
+} // namespace AnnResults
+
+#endif
@@ -0,0 +1,96 @@
+#include <cfloat>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "AnnResultWriter.hpp"
+#include "Exception.h"
+#include "Timer.hpp"
+#include "TypedAnnResultWriter.hpp"
+
+using namespace npp;
+using namespace AnnResults;
+
+static_assert(IsColumn<int>::value && IsColumn<float>::value &&
+                  IsColumn<const char *>::value && !IsColumn<bool>::value &&
+                  !IsColumn<int *>::value,
+              "column types");
+
+std::string slurp(const char *filename) {
+  std::ifstream in(filename);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+int main() {
+  try {
+    std::mt19937 gen(2020);
+    std::uniform_int_distribution<int> ints(-2000000000, 2000000000);
+    std::uniform_real_distribution<double> reals(-1e4, 1e4);
+    std::vector<DefaultWriterE::Row> rows;
+    for (int q = 0; q < 1000; ++q)
+      for (int i = 0; i < 100; ++i)
+        rows.emplace_back(q, i, ints(gen), ints(gen) % 100000,
+                          ints(gen) % 100000, reals(gen), std::abs(reals(gen)),
+                          i % 7);
+    // halfway cases, tiny, huge and special values
+    for (double d : {0.0078125, -0.0078125, 0.5e-6, 2.5e-6, 1e-7, -0.0, 1e300,
+                     -DBL_MAX, 123456.1234565, 0.1, 1.0 / 3}) {
+      rows.emplace_back(0, 0, 0, 0, 0, d, d, 0);
+    }
+
+    HighResolutionTimer timer;
+    timer.restart();
+    {
+      AnnResultWriter writer("typed-ann-result-test.txt", true);
+      writer.writeRow("s", _DEFAULT_HEADER_E_);
+      for (const auto &r : rows)
+        std::apply(
+            [&](auto... v) {
+              NPP_ASSERT(writer.writeRow(_DEFAULT_FMT_E_, v...));
+            },
+            r);
+    }
+    auto e1 = timer.elapsed();
+
+    timer.restart();
+    {
+      DefaultWriterE writer("typed-ann-result-test.typed.txt", true);
+      NPP_ASSERT(writer.writeHeader(_DEFAULT_HEADER_E_));
+      NPP_ASSERT(writer.writeRows(rows));
+    }
+    auto e2 = timer.elapsed();
+    std::cout << rows.size() << " rows, varargs: " << e1
+              << " us, typed: " << e2 << " us" << std::endl;
+    NPP_ASSERT(slurp("typed-ann-result-test.txt") ==
+               slurp("typed-ann-result-test.typed.txt"));
+
+    {
+      // one row at a time with a tiny buffer, float/char/string columns
+      TypedAnnResultWriter<float, char, const char *, std::string, long> writer(
+          "typed-ann-result-test.typed.txt", true, 1);
+      writer.writeRow(0.25f, 'x', "abc", std::string(1000, 'y'),
+                      -1234567890123L);
+      writer.writeRow(std::make_tuple(1.5f, 'z', "", "", 0L));
+      NPP_ASSERT(writer.flush());
+    }
+    NPP_ASSERT(slurp("typed-ann-result-test.typed.txt") ==
+               "0.250000,x,abc," + std::string(1000, 'y') +
+                   ",-1234567890123\n1.500000,z,,,0\n");
+
+    bool thrown = false;
+    try {
+      DefaultWriterI writer("typed-ann-result-test.txt");
+    } catch (const Exception &) {
+      thrown = true; // exists
+    }
+    NPP_ASSERT(thrown);
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  remove("typed-ann-result-test.txt");
+  remove("typed-ann-result-test.typed.txt");
+  return EXIT_SUCCESS;
+}
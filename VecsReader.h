@@ -0,0 +1,580 @@
+#ifndef _VECS_READER_
+#define _VECS_READER_
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ConvertKernels.hpp"
+#include "FilenameUtils.hpp"
+#include "Half.hpp"
+#include "IoEngine.hpp"
+#include "MappedFile.hpp"
+#include "ParallelUtils.hpp"
+#include "PosixFile.hpp"
+#include "Span.hpp"
+#include "VecsView.hpp"
+
+class VecsReaderException : public std::runtime_error {
+public:
+  VecsReaderException(const std::string &rFileName, // filename
+                      unsigned int nLineNumber,     // line number
+                      const std::string &rMessage   // error message
+                      )
+      : std::runtime_error(rFileName + ":" + std::to_string(nLineNumber) +
+                           ": " + rMessage) {}
+};
+
+#define VR_REQUIRED(C)                                                         \
+  do {                                                                         \
+    if (!(C))                                                                  \
+      throw VecsReaderException(__FILE__, __LINE__, #C " is required!");       \
+  } while (false)
+
+#define VR_REQUIRED_MSG(C, M)                                                  \
+  do {                                                                         \
+    if (!(C))                                                                  \
+      throw VecsReaderException(__FILE__, __LINE__,                            \
+                                std::string(#C " is required! Message: ") +    \
+                                    std::string(M));                           \
+  } while (false)
+
+// allocator leaving new elements default-initialized, i.e., arithmetic ones
+// uninitialized, for buffers that are overwritten right away; the pages are
+// then first touched by the threads writing them instead of by a serial
+// zero fill
+template <typename T> struct DefaultInitAllocator : std::allocator<T> {
+  template <typename U> struct rebind {
+    using other = DefaultInitAllocator<U>;
+  };
+  DefaultInitAllocator() = default;
+  template <typename U>
+  DefaultInitAllocator(const DefaultInitAllocator<U> &) noexcept {}
+
+  template <typename U> void construct(U *p) {
+    ::new (static_cast<void *>(p)) U;
+  }
+  template <typename U, typename... Args>
+  void construct(U *p, Args &&...args) {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
+};
+template <typename T>
+using UninitVector = std::vector<T, DefaultInitAllocator<T>>;
+
+// class for .fvecs (ElemT = float), .bvecs (ElemT = uint8_t) and .ivecs
+// (ElemT = int) data. Every point is stored as a 4-byte dimension followed by
+// <dim> elements of type ElemT; points are returned as OutT by default.
+template <typename ElemT, typename OutT = ElemT> class VecsReader {
+  static_assert(std::is_arithmetic<ElemT>::value,
+                "vecs elements must be arithmetic");
+
+public:
+  using ElemType = ElemT;
+  using OutType = OutT;
+  // size of the per-point dimension header in bytes
+  static constexpr size_t HeaderSize = sizeof(int);
+  // size of one coordinate in bytes
+  static constexpr size_t ElemSize = sizeof(ElemT);
+
+  VecsReader(const char *filename) : _filename(filename), _cur_pos(0) {
+    _inf.open(filename, std::ios::in | std::ios::binary);
+    VR_REQUIRED_MSG(_inf.is_open(), "Opening \"" + _filename + "\" failed!");
+    _getSize();
+    _getDim();
+    _sz_each = HeaderSize + _dim * ElemSize;
+    _n = _size / _sz_each;
+  }
+  // noncopyable
+  VecsReader(const VecsReader &) = delete;
+  VecsReader &operator=(const VecsReader &) = delete;
+
+  // get  data dimension
+  unsigned pointDimension() const { return _dim; }
+  // total size in bytes
+  size_t size() const { return _size; }
+  // total number of points
+  size_t numPoints() const { return _n; }
+  // file name
+  const std::string &filename() const { return _filename; }
+
+  // read <n> points starting from current position
+  template <typename T = OutT> std::vector<T> read(size_t n) {
+    if (n > numPoints() - _cur_pos) // at most the remaining points
+      n = numPoints() - _cur_pos;
+    std::vector<T> data(n * _dim);
+    auto true_n = readInto(data.data(), n);
+    data.resize(true_n * _dim);
+    return data;
+  }
+
+  // read <n> points starting from current position into <dst>, where
+  // consecutive points are <ld> elements apart (pointDimension() if 0);
+  // returns the number of points read. Reads go through one reused scratch
+  // buffer so no memory is allocated once it has grown to its final size.
+  template <typename T = OutT>
+  size_t readInto(T *dst, size_t n, size_t ld = 0) {
+    if (ld == 0)
+      ld = _dim;
+    VR_REQUIRED(ld >= _dim);
+    const size_t block = _scratchPoints();
+    if (_scratch.size() < std::min(n, block) * _sz_each)
+      _scratch.resize(std::min(n, block) * _sz_each);
+    size_t true_n = 0;
+    while (true_n < n) {
+      size_t m = std::min(block, n - true_n);
+      size_t sz = m * _sz_each;
+      _inf.read(_scratch.data(), sz);
+      if (!_inf.good()) { // read failed
+        size_t read_sz = _inf.gcount();
+#ifdef DEBUG
+        fprintf(stderr, "read %lu points failed, ONLY %lu was read\n", n,
+                true_n + read_sz / _sz_each);
+#endif
+        VR_REQUIRED_MSG(read_sz % _sz_each == 0, "Bad vecs file!");
+        m = read_sz / _sz_each;
+        n = true_n + m; // stop after this block
+      }
+      for (size_t i = 0; i < m; ++i)
+        _convertRow(_rowData(_scratch.data() + i * _sz_each),
+                    dst + (true_n + i) * ld, _dim);
+      true_n += m;
+    }
+    _cur_pos += true_n; // update current
+
+    return true_n;
+  }
+
+  // read from a-th point (including) until b-th point (not including) into
+  // <dst>, where consecutive points are <ld> elements apart (pointDimension()
+  // if 0) and which must be large enough for the points up to <b> (or the end
+  // of the file); returns the number of points read
+  template <typename T>
+  size_t readInto(Span<T> dst, // destination
+                  size_t a,    // first (including)
+                  size_t b,    // last (excluding)
+                  size_t ld = 0) {
+    VR_REQUIRED(b > a);
+    if (a >= numPoints())
+      return 0;
+    if (b > numPoints())
+      b = numPoints();
+    if (ld == 0)
+      ld = _dim;
+    VR_REQUIRED(ld >= _dim);
+    VR_REQUIRED_MSG(dst.size() >= (b - a - 1) * ld + _dim,
+                    "Destination is too small");
+
+    if (_engine) { // positioned reads, then continue the stream after <b>
+      // one block at a time through the scratch buffer, as readInto() does
+      const size_t block = _scratchPoints();
+      if (_scratch.size() < std::min(b - a, block) * _sz_each)
+        _scratch.resize(std::min(b - a, block) * _sz_each);
+      _reqs.resize(1);
+      for (size_t i = a; i < b; i += block) {
+        size_t m = std::min(block, b - i);
+        _reqs[0] = {i * _sz_each, m * _sz_each, _scratch.data(), 0};
+        _engine->submit(_reqs);
+        VR_REQUIRED_MSG(_reqs[0].done == _reqs[0].length, "Bad vecs file!");
+        for (size_t j = 0; j < m; ++j) {
+          const char *row = _scratch.data() + j * _sz_each;
+          _checkDim(row, i + j);
+          _convertRow(_rowData(row), dst.data() + (i + j - a) * ld, _dim);
+        }
+      }
+      _seekTo(b * _sz_each);
+      return b - a;
+    }
+
+    if (a != _cur_pos) { // starting is not _cur_pos
+      size_t pos = a * _sz_each;
+      if (!_seekTo(pos)) // <a> is too large
+        return 0;
+    }
+
+    return readInto(dst.data(), b - a, ld);
+  }
+
+  // read from a-th point (including) until b-th point (not including)
+  template <typename T = OutT>
+  std::vector<T> read(size_t a, // first (including)
+                      size_t b  // last (excluding)
+  ) {
+    VR_REQUIRED(b > a);
+    if (a >= numPoints())
+      return {};
+    if (b > numPoints())
+      b = numPoints();
+
+    std::vector<T> data((b - a) * _dim);
+    auto true_n = readInto(Span<T>(data), a, b);
+    data.resize(true_n * _dim);
+    return data;
+  }
+
+  // read all remaining points starting from current position
+  template <typename T = OutT> std::vector<T> read() {
+    auto n = numPoints() - _cur_pos;
+    if (n == 0)
+      return {};
+    return read<T>(n);
+  }
+
+  // read all points with <numThreads> threads (0 for all cores) issuing
+  // concurrent preads over point-aligned ranges; every point's dim is checked
+  // and the current position is unchanged. The result is not zero-filled
+  // first, every element is written once by the thread reading it.
+  template <typename T = OutT>
+  UninitVector<T> loadAll(unsigned numThreads = 0) {
+    UninitVector<T> data(_n * _dim);
+    // points per pread, bounds the per-thread buffer to about 8MB
+    const size_t block = std::max<size_t>(1, (8u << 20) / _sz_each);
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t i = 0; i < _n; i += block)
+      ranges.emplace_back(i, std::min(_n, i + block));
+    _readRanges(ranges, numThreads, [&](size_t r, const char *raw) {
+      for (size_t i = ranges[r].first; i < ranges[r].second; ++i) {
+        const char *row = raw + (i - ranges[r].first) * _sz_each;
+        _checkDim(row, i);
+        _convertRow(_rowData(row), &data[i * _dim], _dim);
+      }
+    });
+    return data;
+  }
+
+  // read the points with the given ids (any order, duplicates allowed) and
+  // return them in the order of <ids>. Sorted ids at most <maxGap> points
+  // apart are coalesced into one pread and the reads are issued from
+  // <numThreads> threads (0 for all cores); the current position is unchanged.
+  // The blocks read by the I/O engine for this call, e.g., the #io of a
+  // query, are stored in <ios> if given (0 without an engine).
+  template <typename T = OutT>
+  std::vector<T> gather(const std::vector<size_t> &ids, size_t maxGap = 8,
+                        unsigned numThreads = 0, size_t *ios = nullptr) {
+    std::vector<T> data(ids.size() * _dim);
+    if (ios)
+      *ios = 0;
+    if (ids.empty())
+      return data;
+
+    // (id, position in <ids>) sorted by id
+    std::vector<std::pair<size_t, size_t>> order(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      VR_REQUIRED_MSG(ids[i] < _n, "Point id " + std::to_string(ids[i]) +
+                                       " is out of range");
+      order[i] = {ids[i], i};
+    }
+    std::sort(order.begin(), order.end());
+
+    // coalesce into runs of [order[first], order[last]), a run never spans
+    // more than about 4MB so that runs can be spread over threads
+    const size_t maxRun = _scratchPoints();
+    std::vector<std::pair<size_t, size_t>> runs, ranges;
+    for (size_t i = 0, first = 0; i < order.size(); ++i) {
+      bool end = (i + 1 == order.size()) ||
+                 order[i + 1].first - order[i].first > maxGap + 1 ||
+                 order[i + 1].first - order[first].first >= maxRun;
+      if (end) {
+        runs.emplace_back(first, i + 1);
+        ranges.emplace_back(order[first].first, order[i].first + 1);
+        first = i + 1;
+      }
+    }
+
+    size_t n = _readRanges(ranges, numThreads, [&](size_t r, const char *raw) {
+      for (size_t i = runs[r].first; i < runs[r].second; ++i) {
+        const char *row = raw + (order[i].first - ranges[r].first) * _sz_each;
+        _checkDim(row, order[i].first);
+        _convertRow(_rowData(row), &data[order[i].second * _dim], _dim);
+      }
+    });
+    if (ios)
+      *ios = n;
+    return data;
+  }
+
+  // read <k> distinct points drawn uniformly at random with <seed> (all
+  // points if k >= numPoints()) in increasing id order, e.g., as a training
+  // set; the ids are stored in <ids> if given. The points are read with
+  // gather(), so nearby ids share one pread.
+  template <typename T = OutT>
+  std::vector<T> sample(size_t k, uint64_t seed,
+                        std::vector<size_t> *ids = nullptr,
+                        unsigned numThreads = 0) {
+    std::vector<size_t> picked;
+    if (k >= _n) {
+      picked.resize(_n);
+      for (size_t i = 0; i < _n; ++i)
+        picked[i] = i;
+    } else if (k * 8 >= _n) {
+      // selection sampling (Knuth's algorithm S), already sorted
+      std::mt19937_64 gen(seed);
+      std::uniform_real_distribution<double> dist(0.0, 1.0);
+      picked.reserve(k);
+      for (size_t i = 0; i < _n && picked.size() < k; ++i)
+        if ((_n - i) * dist(gen) < k - picked.size())
+          picked.push_back(i);
+    } else {
+      // Floyd's algorithm, O(k) draws for a sparse sample
+      std::mt19937_64 gen(seed);
+      std::unordered_set<size_t> chosen;
+      chosen.reserve(2 * k);
+      for (size_t j = _n - k; j < _n; ++j) {
+        size_t t = std::uniform_int_distribution<size_t>(0, j)(gen);
+        chosen.insert(chosen.count(t) ? j : t);
+      }
+      picked.assign(chosen.begin(), chosen.end());
+      std::sort(picked.begin(), picked.end());
+    }
+    auto data = gather<T>(picked, 8, numThreads);
+    if (ids)
+      *ids = std::move(picked);
+    return data;
+  }
+
+  // read every <m>-th point starting from the <offset>-th one, a
+  // deterministic subset; the ids are stored in <ids> if given
+  template <typename T = OutT>
+  std::vector<T> sampleStrided(size_t m, size_t offset = 0,
+                               std::vector<size_t> *ids = nullptr,
+                               unsigned numThreads = 0) {
+    VR_REQUIRED(m > 0);
+    std::vector<size_t> picked;
+    for (size_t i = offset; i < _n; i += m)
+      picked.push_back(i);
+    auto data = gather<T>(picked, 8, numThreads);
+    if (ids)
+      *ids = std::move(picked);
+    return data;
+  }
+
+  // zero-copy view of the a-th point (including) until b-th point (not
+  // including) over the memory-mapped file, the current position is unchanged
+  VecsView<ElemT> view(size_t a, size_t b,
+                       MappedFile::Advice advice = MappedFile::Sequential) {
+    VR_REQUIRED(b > a);
+    if (a >= numPoints())
+      return {};
+    if (b > numPoints())
+      b = numPoints();
+    _map();
+    _mapped->advise(advice, a * _sz_each, (b - a) * _sz_each);
+    auto first = _mapped->data() + a * _sz_each;
+    return VecsView<ElemT>(_rowData(first), b - a, _dim, _sz_each / ElemSize);
+  }
+
+  // zero-copy view of all points
+  VecsView<ElemT> view(MappedFile::Advice advice = MappedFile::Sequential) {
+    if (numPoints() == 0)
+      return {};
+    return view(0, numPoints(), advice);
+  }
+
+  // route range reads, gather() and loadAll() through <engine>, which must
+  // be opened on the same file; nullptr restores the default reads
+  void setIoEngine(std::shared_ptr<IoEngine> engine) {
+    VR_REQUIRED_MSG(!engine || engine->size() == _size,
+                    "I/O engine is opened on another file");
+    _engine = std::move(engine);
+  }
+  IoEngine *ioEngine() const { return _engine.get(); }
+
+  // seek to the begining of the file
+  void rewind() {
+    _inf.clear();
+    _inf.seekg(0, _inf.beg);
+    _cur_pos = 0;
+  }
+
+private:
+  // coordinates of the point stored at <raw>, i.e., skip the dim part
+  static const ElemT *_rowData(const char *raw) {
+    return reinterpret_cast<const ElemT *>(raw + HeaderSize);
+  }
+
+  // copy one point out of the file buffer, the identity case is a plain memcpy
+  // and widening uint8_t coordinates uses the SIMD kernels
+  template <typename T>
+  static void _convertRow(const ElemT *src, T *dst, unsigned dim) {
+    constexpr bool fromU8 = std::is_same<ElemT, uint8_t>::value;
+    constexpr bool fromF32 = std::is_same<ElemT, float>::value;
+    if constexpr (std::is_same<T, ElemT>::value) {
+      std::memcpy(dst, src, dim * ElemSize);
+    } else if constexpr (fromU8 && std::is_same<T, float>::value) {
+      ConvertKernels::u8ToF32(src, dst, dim);
+    } else if constexpr (fromU8 && std::is_same<T, uint16_t>::value) {
+      ConvertKernels::u8ToU16(src, dst, dim);
+    } else if constexpr (fromU8 && std::is_same<T, Float16>::value) {
+      ConvertKernels::u8ToF16(src, reinterpret_cast<uint16_t *>(dst), dim);
+    } else if constexpr (fromF32 && IsHalf<T>::value) {
+      floatToHalf(src, dst, dim);
+    } else {
+      for (unsigned k = 0; k < dim; ++k)
+        dst[k] = static_cast<T>(src[k]);
+    }
+  }
+
+  // get data dimension from file
+  void _getDim() {
+    _inf.read((char *)&_dim, sizeof(unsigned));
+    VR_REQUIRED_MSG(_inf.good(), "Read dimension failed");
+    _inf.seekg(0, _inf.beg);
+  }
+
+  // points per read through the scratch buffer, which is about 4MB
+  size_t _scratchPoints() const {
+    return std::max<size_t>(1, (4u << 20) / _sz_each);
+  }
+
+  // check the dim part of the <i>-th point stored at <raw>
+  void _checkDim(const char *raw, size_t i) const {
+    unsigned dim;
+    std::memcpy(&dim, raw, sizeof(unsigned));
+    VR_REQUIRED_MSG(dim == _dim, "Bad vecs file! Point " + std::to_string(i) +
+                                     " has dimension " + std::to_string(dim));
+  }
+
+  // read the raw points of every range [lo, hi) in <ranges> and call
+  // fn(r, raw) for range r, through the I/O engine when one is set and with
+  // concurrent preads from <numThreads> threads otherwise; returns the blocks
+  // read by the engine
+  template <typename Fn>
+  size_t _readRanges(const std::vector<std::pair<size_t, size_t>> &ranges,
+                     unsigned numThreads, Fn fn) {
+    if (!_engine) {
+      _open();
+      ParallelUtils::parallelFor(
+          ranges.size(), numThreads, [&](size_t a, size_t b, unsigned) {
+            std::vector<char> buf;
+            for (size_t r = a; r < b; ++r) {
+              size_t sz = (ranges[r].second - ranges[r].first) * _sz_each;
+              buf.resize(sz);
+              VR_REQUIRED_MSG(_file->pread(buf.data(), sz,
+                                           ranges[r].first * _sz_each) == sz,
+                              "Bad vecs file!");
+              fn(r, buf.data());
+            }
+          });
+      return 0;
+    }
+
+    // submit batches of about 64MB to the engine, then convert in parallel
+    const size_t batch = 64u << 20;
+    size_t ios = 0;
+    std::vector<char> buf;
+    std::vector<IoRequest> reqs;
+    for (size_t first = 0, last = 0; first < ranges.size(); first = last) {
+      size_t bytes = 0;
+      for (last = first; last < ranges.size(); ++last) {
+        size_t sz = (ranges[last].second - ranges[last].first) * _sz_each;
+        if (last > first && bytes + sz > batch)
+          break;
+        bytes += sz;
+      }
+      buf.resize(bytes);
+      reqs.clear();
+      for (size_t r = first, off = 0; r < last; ++r) {
+        size_t sz = (ranges[r].second - ranges[r].first) * _sz_each;
+        reqs.push_back({ranges[r].first * _sz_each, sz, buf.data() + off, 0});
+        off += sz;
+      }
+      _engine->submit(reqs);
+      for (const auto &req : reqs) {
+        VR_REQUIRED_MSG(req.done == req.length, "Bad vecs file!");
+        ios += req.ios;
+      }
+      ParallelUtils::parallelFor(
+          last - first, numThreads, [&](size_t a, size_t b, unsigned) {
+            for (size_t i = a; i < b; ++i)
+              fn(first + i, reqs[i].dst);
+          });
+    }
+    return ios;
+  }
+
+  // open the file for positioned reads on first use
+  void _open() {
+    if (!_file)
+      _file.reset(new PosixFile(_filename));
+  }
+
+  // memory map the file on first use
+  void _map() {
+    if (!_mapped)
+      _mapped.reset(new MappedFile(_filename));
+  }
+
+  bool _seekTo(size_t pos) {
+    if (pos > size() || (pos % _sz_each != 0))
+      return false;
+    rewind();
+    _inf.seekg(pos);
+    _cur_pos = pos / _sz_each;
+    return true;
+  }
+
+  // size of the file in bytes
+  void _getSize() {
+    _inf.seekg(0, _inf.end);
+    _size = _inf.tellg();
+    _inf.seekg(0, _inf.beg);
+  }
+
+  std::string _filename; // filename
+  size_t _cur_pos;       // current position (in points not bytes)
+  std::ifstream _inf;    // file stream
+  unsigned _dim;         // data dimension
+  size_t _size;
+  size_t _n;
+  size_t _sz_each;
+  std::vector<char> _scratch;          // reused by readInto
+  std::vector<IoRequest> _reqs;        // reused by engine range reads
+  std::unique_ptr<MappedFile> _mapped; // lazily created mapping
+  std::unique_ptr<PosixFile> _file;    // lazily opened for preads
+  std::shared_ptr<IoEngine> _engine;   // optional batched I/O backend
+};
+
+using FvecsReader = VecsReader<float>;
+using BvecsReader = VecsReader<uint8_t>;
+using IvecsReader = VecsReader<int>;
+
+// open <filename> with the reader matching its extension (.fvecs, .bvecs or
+// .ivecs) and call <vis> with it; points are read as OutT by default
+template <typename OutT, typename Visitor>
+auto visitVecsReader(const std::string &filename, Visitor &&vis) {
+  auto ext = StringUtils::toLower(FilenameUtils::getExtension(filename));
+  if (ext == ".fvecs") {
+    VecsReader<float, OutT> reader(filename.c_str());
+    return vis(reader);
+  } else if (ext == ".bvecs") {
+    VecsReader<uint8_t, OutT> reader(filename.c_str());
+    return vis(reader);
+  } else if (ext == ".ivecs") {
+    VecsReader<int, OutT> reader(filename.c_str());
+    return vis(reader);
+  }
+  throw VecsReaderException(__FILE__, __LINE__,
+                            "Unsupported vecs file \"" + filename + "\"");
+}
+
+// read all points of a .fvecs/.bvecs/.ivecs file as OutT
+template <typename OutT>
+std::vector<OutT> readVecs(const std::string &filename,
+                           unsigned *dim = nullptr) {
+  return visitVecsReader<OutT>(filename, [dim](auto &reader) {
+    if (dim)
+      *dim = reader.pointDimension();
+    return reader.read();
+  });
+}
+
+#endif // _VECS_READER_
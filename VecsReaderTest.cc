@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include "Exception.h"
+#include "VecsReader.h"
+
+using namespace npp;
+
+// count heap allocations to check that readInto does not allocate, GCC
+// cannot tell that the replaced operator new is malloc based
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+static size_t allocations = 0;
+void *operator new(size_t sz) {
+  ++allocations;
+  if (void *p = malloc(sz))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+const char *FVF = "./sample-data/gist_query.fvecs";
+const char *IVF = "vecs-reader-test.ivecs";
+
+// write <n> points of dimension <dim> with coordinates i * dim + j
+void writeIvecs(const char *filename, size_t n, int dim) {
+  FILE *fp = fopen(filename, "wb");
+  NPP_ASSERT_NOT_NULL(fp);
+  for (size_t i = 0; i < n; ++i) {
+    fwrite(&dim, sizeof(int), 1, fp);
+    for (int j = 0; j < dim; ++j) {
+      int v = static_cast<int>(i * dim + j) - 50;
+      fwrite(&v, sizeof(int), 1, fp);
+    }
+  }
+  fclose(fp);
+}
+
+int main() {
+  try {
+    {
+      writeIvecs(IVF, 20, 7);
+      IvecsReader reader(IVF);
+      NPP_ASSERT(reader.numPoints() == 20 && reader.pointDimension() == 7);
+      auto all = reader.read();
+      NPP_ASSERT(all.size() == 20 * 7);
+      for (size_t i = 0; i < all.size(); ++i)
+        NPP_ASSERT(all[i] == static_cast<int>(i) - 50);
+      auto part = reader.read<double>(3, 5);
+      NPP_ASSERT(part.size() == 2 * 7 && part[0] == 3 * 7 - 50);
+      remove(IVF);
+    }
+
+    {
+      for (unsigned threads : {0u, 1u, 3u, 64u}) {
+        FvecsReader reader(FVF);
+        reader.read(2);
+        auto all = reader.loadAll(threads);
+        auto next = reader.read(1); // position is unchanged
+        reader.rewind();
+        auto expect = reader.read();
+        NPP_ASSERT(std::equal(all.begin(), all.end(), expect.begin(),
+                              expect.end()));
+        NPP_ASSERT(std::equal(next.begin(), next.end(),
+                              all.begin() + 2 * reader.pointDimension()));
+        BvecsReader breader(BVF);
+        auto ball = breader.loadAll<float>(threads);
+        auto bexpect = breader.read<float>();
+        NPP_ASSERT(std::equal(ball.begin(), ball.end(), bexpect.begin(),
+                              bexpect.end()));
+      }
+
+      // a point with a wrong dim part is reported
+      writeIvecs(IVF, 20, 7);
+      FILE *fp = fopen(IVF, "r+b");
+      int bad = 8;
+      fseek(fp, 13 * 8 * sizeof(int), SEEK_SET);
+      fwrite(&bad, sizeof(int), 1, fp);
+      fclose(fp);
+      IvecsReader reader(IVF);
+      bool thrown = false;
+      try {
+        reader.loadAll(4);
+      } catch (const VecsReaderException &e) {
+        thrown = std::string(e.what()).find("Point 13") != std::string::npos;
+      }
+      NPP_ASSERT(thrown);
+      remove(IVF);
+    }
+
+    {
+      FvecsReader reader(FVF);
+      const unsigned dim = reader.pointDimension();
+      auto expect = reader.read<double>();
+      reader.rewind();
+      std::vector<double> buf(16 * dim);
+      NPP_ASSERT(reader.readInto(buf.data(), 16) == 16);
+      NPP_ASSERT(std::equal(buf.begin(), buf.end(), expect.begin()));
+
+      // steady state reads do not allocate
+      auto before = allocations;
+      for (size_t i = 16; i + 16 <= reader.numPoints(); i += 16) {
+        NPP_ASSERT(reader.readInto(buf.data(), 16) == 16);
+        NPP_ASSERT(buf[0] == expect[i * dim]);
+      }
+      Span<double> dst(buf);
+      NPP_ASSERT(reader.readInto(dst, 3, 5) == 2);
+      NPP_ASSERT(buf[dim] == expect[4 * dim]);
+      NPP_ASSERT(allocations == before);
+
+      // short reads at the end of the file
+      auto n = reader.readInto(dst, reader.numPoints() - 1,
+                               reader.numPoints() + 15);
+      NPP_ASSERT(n == 1);
+      NPP_ASSERT(reader.readInto(buf.data(), 16) == 0);
+      NPP_ASSERT(reader.readInto(dst, reader.numPoints(),
+                                 reader.numPoints() + 1) == 0);
+      bool thrown = false;
+      try {
+        reader.readInto(dst, 0, 17);
+      } catch (const VecsReaderException &) {
+        thrown = true;
+      }
+      NPP_ASSERT(thrown);
+    }
+
+    {
+      BvecsReader reader(BVF);
+      const unsigned dim = reader.pointDimension();
+      auto all = reader.read<float>();
+      std::mt19937 gen(2020);
+      std::uniform_int_distribution<size_t> dist(0, reader.numPoints() - 1);
+      std::vector<size_t> ids(500);
+      for (auto &id : ids)
+        id = dist(gen);
+      ids.push_back(ids[3]); // duplicates keep their slots
+      ids.push_back(reader.numPoints() - 1);
+      ids.push_back(0);
+      for (size_t gap : {0, 8, 1000}) {
+        for (unsigned threads : {1u, 4u}) {
+          auto rows = reader.gather<float>(ids, gap, threads);
+          NPP_ASSERT(rows.size() == ids.size() * dim);
+          for (size_t i = 0; i < ids.size(); ++i)
+            NPP_ASSERT(std::equal(rows.begin() + i * dim,
+                                  rows.begin() + (i + 1) * dim,
+                                  all.begin() + ids[i] * dim));
+        }
+      }
+      NPP_ASSERT(reader.gather({}).empty());
+      bool thrown = false;
+      try {
+        reader.gather({1, reader.numPoints()});
+      } catch (const VecsReaderException &) {
+        thrown = true;
+      }
+      NPP_ASSERT(thrown);
+    }
+
+    {
+      BvecsReader reader(BVF);
+      const unsigned dim = reader.pointDimension();
+      auto all = reader.read<float>();
+      // sparse (Floyd), dense (selection sampling) and full samples
+      for (size_t k : {1, 100, 3000, 20000}) {
+        std::vector<size_t> ids, again;
+        auto rows = reader.sample<float>(k, 42, &ids);
+        auto same = reader.sample<float>(k, 42, &again);
+        size_t expect = std::min<size_t>(k, reader.numPoints());
+        NPP_ASSERT(ids.size() == expect && rows.size() == expect * dim);
+        NPP_ASSERT(ids == again && rows == same); // deterministic
+        for (size_t i = 0; i < ids.size(); ++i) {
+          NPP_ASSERT(ids[i] < reader.numPoints());
+          NPP_ASSERT(i == 0 || ids[i - 1] < ids[i]); // sorted and distinct
+          NPP_ASSERT(std::equal(rows.begin() + i * dim,
+                                rows.begin() + (i + 1) * dim,
+                                all.begin() + ids[i] * dim));
+        }
+      }
+      std::vector<size_t> a, b;
+      reader.sample(100, 1, &a);
+      reader.sample(100, 2, &b);
+      NPP_ASSERT(a != b);
+
+      std::vector<size_t> ids;
+      auto rows = reader.sampleStrided<float>(1000, 7, &ids);
+      NPP_ASSERT(ids.size() == 10 && ids[0] == 7 && ids[9] == 9007);
+      for (size_t i = 0; i < ids.size(); ++i)
+        NPP_ASSERT(std::equal(rows.begin() + i * dim,
+                              rows.begin() + (i + 1) * dim,
+                              all.begin() + ids[i] * dim));
+      NPP_ASSERT(reader.sampleStrided(1, reader.numPoints()).empty());
+    }
+
+    {
+      // bytes above 127 must not be sign extended
+      BvecsReader reader(BVF);
+      auto bytes = reader.read(0, 100);
+      auto floats = reader.read<float>(0, 100);
+      auto ints = reader.read<int>(0, 100);
+      NPP_ASSERT(bytes.size() == floats.size() && bytes.size() == ints.size());
+      bool seenLarge = false;
+      for (size_t i = 0; i < bytes.size(); ++i) {
+        NPP_ASSERT(floats[i] == static_cast<float>(bytes[i]));
+        NPP_ASSERT(ints[i] == static_cast<int>(bytes[i]) && ints[i] >= 0);
+        seenLarge = seenLarge || bytes[i] > 127;
+      }
+      NPP_ASSERT(seenLarge);
+
+      // a short read can be followed by a rewind
+      auto tail = reader.read(reader.numPoints() - 1, reader.numPoints() + 10);
+      NPP_ASSERT(tail.size() == reader.pointDimension());
+      reader.rewind();
+      auto again = reader.read(1);
+      NPP_ASSERT(again.size() == reader.pointDimension() && again[0] == bytes[0]);
+    }
+
+    {
+      unsigned dim = 0;
+      auto viaDispatch = readVecs<float>(FVF, &dim);
+      FvecsReader reader(FVF);
+      auto direct = reader.read();
+      NPP_ASSERT(dim == reader.pointDimension());
+      NPP_ASSERT(viaDispatch == direct);
+
+      auto n = visitVecsReader<float>(
+          BVF, [](auto &r) { return r.numPoints(); });
+      NPP_ASSERT(n == BvecsReader(BVF).numPoints());
+
+      bool thrown = false;
+      try {
+        readVecs<float>("a/b/x.txt");
+      } catch (const VecsReaderException &) {
+        thrown = true;
+      }
+      NPP_ASSERT(thrown);
+    }
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,47 @@
+#ifndef _VECS_VIEW_HPP_
+#define _VECS_VIEW_HPP_
+
+#include <cstddef>
+
+// non-owning strided view over rows of a vecs file, e.g., a memory mapping.
+// Consecutive rows are <stride> elements apart, which skips the per-row
+// dimension header of the .bvecs/.fvecs formats without copying.
+template <typename T> class VecsView {
+public:
+  VecsView() : _data(nullptr), _n(0), _dim(0), _stride(0) {}
+  VecsView(const T *data, size_t n, unsigned dim, size_t stride)
+      : _data(data), _n(n), _dim(dim), _stride(stride) {}
+
+  // get data dimension
+  unsigned pointDimension() const { return _dim; }
+  // total number of points
+  size_t numPoints() const { return _n; }
+  // distance between two consecutive rows (in elements not bytes)
+  size_t stride() const { return _stride; }
+  bool empty() const { return _n == 0; }
+  // first coordinate of the first point
+  const T *data() const { return _data; }
+
+  // first coordinate of the i-th point
+  const T *row(size_t i) const { return _data + i * _stride; }
+  const T *operator[](size_t i) const { return row(i); }
+  // j-th coordinate of the i-th point
+  const T &operator()(size_t i, unsigned j) const { return row(i)[j]; }
+
+  // view of points [a, b) of this view
+  VecsView sub(size_t a, size_t b) const {
+    if (a >= _n || b <= a)
+      return VecsView(nullptr, 0, _dim, _stride);
+    if (b > _n)
+      b = _n;
+    return VecsView(row(a), b - a, _dim, _stride);
+  }
+
+private:
+  const T *_data;
+  size_t _n;
+  unsigned _dim;
+  size_t _stride;
+};
+
+#endif // _VECS_VIEW_HPP_
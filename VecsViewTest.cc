@@ -0,0 +1,55 @@
+#include <iostream>
+#include "BvecsReader.h"
+#include "Exception.h"
+#include "FvecsReader.h"
+
+using namespace npp;
+
+const char *BVF = "./sample-data/bigann_query.bvecs";
+const char *FVF = "./sample-data/gist_query.fvecs";
+
+template <typename Reader> void checkView(Reader &reader) {
+  auto all = reader.read(0, reader.numPoints());
+  auto view = reader.view();
+  NPP_ASSERT(view.numPoints() == reader.numPoints());
+  NPP_ASSERT(view.pointDimension() == reader.pointDimension());
+  for (size_t i = 0; i < view.numPoints(); ++i)
+    for (unsigned j = 0; j < view.pointDimension(); ++j)
+      NPP_ASSERT(view(i, j) == all[i * reader.pointDimension() + j]);
+
+  // window reads do not move the current position
+  reader.rewind();
+  auto window = reader.view(5, 9, MappedFile::Random);
+  NPP_ASSERT(window.numPoints() == 4);
+  auto first = reader.read(1);
+  NPP_ASSERT(first.size() == reader.pointDimension());
+  NPP_ASSERT(first[0] == all[0]);
+  auto expect = reader.read(5, 9);
+  for (size_t i = 0; i < window.numPoints(); ++i)
+    for (unsigned j = 0; j < window.pointDimension(); ++j)
+      NPP_ASSERT(window[i][j] == expect[i * reader.pointDimension() + j]);
+
+  auto sub = window.sub(1, 100);
+  NPP_ASSERT(sub.numPoints() == 3 && sub.row(0) == window.row(1));
+
+  auto clipped = reader.view(reader.numPoints() - 1, reader.numPoints() + 10);
+  NPP_ASSERT(clipped.numPoints() == 1);
+  NPP_ASSERT(reader.view(reader.numPoints(), reader.numPoints() + 1).empty());
+}
+
+int main() {
+  try {
+    {
+      BvecsReader reader(BVF);
+      checkView(reader);
+    }
+    {
+      FvecsReader reader(FVF);
+      checkView(reader);
+    }
+  } catch (const Exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
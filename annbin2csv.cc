@@ -0,0 +1,22 @@
+#include "AnnResultBin.hpp"
+#include <iostream>
+
+int main(int argc, char **argv) {
+  if (!(argc == 2 || argc == 3)) {
+    fprintf(stderr, "Usage: %s <binary result file> [csv filename]\n\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::string input = argv[1];
+  std::string output = (argc == 3) ? argv[2] : input + ".csv";
+  try {
+    AnnResultBinReader reader(input);
+    reader.toCsv(output);
+    printf("wrote %lu rows of %s to %s\n", reader.numRows(),
+           reader.header().c_str(), output.c_str());
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,22 @@
+#include "AnnEvaluator.hpp"
+#include <iostream>
+
+int main(int argc, char **argv) {
+  if (!(argc == 3 || argc == 4)) {
+    fprintf(stderr,
+            "Usage: %s <ground truth .ivecs> [ground truth distances "
+            ".fvecs/.ivecs] <result file>\n\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  try {
+    GroundTruth gt(argv[1], argc == 4 ? argv[2] : "");
+    auto results = loadAnnResults(argv[argc - 1]);
+    auto ev = evaluate(gt, results);
+    printf("%s\n", ev.summary().c_str());
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
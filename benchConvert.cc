@@ -0,0 +1,56 @@
+#include "ConvertKernels.hpp"
+#include "Timer.hpp"
+#include <cstdint>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+using namespace ConvertKernels;
+
+// best of <reps> runs of converting <src>, reported as input GB/s
+template <typename In, typename Out, typename Fn>
+double bench(Fn fn, const std::vector<In> &src, std::vector<Out> &dst,
+             unsigned reps) {
+  HighResolutionTimer timer;
+  double best = 0;
+  for (unsigned r = 0; r < reps; ++r) {
+    timer.restart();
+    fn(src.data(), dst.data(), src.size());
+    auto el = timer.elapsed();
+    if (r == 0 || el < best)
+      best = el;
+  }
+  return src.size() * sizeof(In) / best / 1e3;
+}
+
+int main() {
+  size_t n = 1u << 24; // 16M coordinates, i.e., 128K SIFT points
+  unsigned reps = 10;
+  std::vector<uint8_t> src(n);
+  std::mt19937 gen(2020);
+  std::uniform_int_distribution<int> dist(0, 255);
+  for (auto &v : src)
+    v = static_cast<uint8_t>(dist(gen));
+  std::vector<float> f(n), g(n);
+  std::vector<uint16_t> u(n);
+  std::normal_distribution<float> normal(0.0f, 1.0f);
+  for (auto &v : g)
+    v = normal(gen);
+
+  printf("converting %lu coordinates, best of %u runs (GB/s of input)\n", n,
+         reps);
+  printf("%-8s %10s %10s %10s %10s %10s\n", "isa", "u8->f32", "u8->u16",
+         "u8->f16", "f32->f16", "f32->bf16");
+  auto best = detectIsa();
+  for (int isa = Scalar; isa <= best; ++isa) {
+    auto k = kernelsFor(static_cast<Isa>(isa));
+    auto e1 = bench(k.u8ToF32, src, f, reps);
+    auto e2 = bench(k.u8ToU16, src, u, reps);
+    auto e3 = bench(k.u8ToF16, src, u, reps);
+    auto e4 = bench(k.f32ToF16, g, u, reps);
+    auto e5 = bench(k.f32ToBf16, g, u, reps);
+    printf("%-8s %10.2f %10.2f %10.2f %10.2f %10.2f\n", isaName(k.isa), e1,
+           e2, e3, e4, e5);
+  }
+  return 0;
+}
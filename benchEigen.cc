@@ -1,4 +1,8 @@
+#include "EigenViews.hpp"
+#include "NumberFormat.hpp"
+#include "Profiler.hpp"
 #include "Timer.hpp"
+#include "VecsReader.h"
 #include <cassert>
 #include <chrono>
 #include <eigen3/Eigen/Dense>
@@ -120,6 +124,61 @@ std::vector<T> flatVecMutiply(const std::vector<T> &M,
   return y;
 }
 
+// scores of the first <nq> points against all points of a .fvecs file, end
+// to end: reading, converting into a MatrixXd, then GEMM in double versus
+// GEMM in float over zero-copy maps of the read buffer, the memory mapping
+// and an aligned dataset
+void benchRealData(const char *filename, unsigned nq) {
+  FvecsReader reader(filename);
+  const unsigned dim = reader.pointDimension();
+  const size_t n = reader.numPoints();
+  if (nq > n)
+    nq = n;
+  printf("%s: %lu points, dim = %u, %u queries\n", filename, n, dim, nq);
+  HighResolutionTimer timer;
+
+  timer.restart();
+  auto flat = reader.read(0, n);
+  auto eRead = timer.elapsed();
+  timer.restart();
+  auto mat = flatVecToEigenMat<float>(flat, n, dim);
+  MatrixXd qd = mat.topRows(nq).transpose();
+  auto eConvert = timer.elapsed();
+  timer.restart();
+  MatrixXd sd = mat * qd;
+  auto eGemmD = timer.elapsed();
+
+  // the queries are columns of a dim x nq matrix in both cases
+  auto m1 = eigenMap(flat, dim);
+  MatrixXf qf = m1.topRows(nq).transpose();
+  timer.restart();
+  MatrixXf s1 = m1 * qf;
+  auto eGemmF = timer.elapsed();
+
+  timer.restart();
+  auto m2 = eigenMap(reader.view());
+  MatrixXf s2 = m2 * qf;
+  auto eMapped = timer.elapsed();
+
+  timer.restart();
+  auto ds = readDataset<float>(reader);
+  auto eDataset = timer.elapsed();
+  timer.restart();
+  MatrixXf s3 = eigenMap(ds) * qf;
+  auto eGemmDs = timer.elapsed();
+
+  double err = (sd - s1.cast<double>()).cwiseAbs().maxCoeff();
+  assert(s1.isApprox(s2) && s1.isApprox(s3));
+  printf("read + convert + GEMM (double): %.2f + %.2f + %.2f = %.2f us\n",
+         eRead, eConvert, eGemmD, eRead + eConvert + eGemmD);
+  printf("read + map + GEMM (float): %.2f + 0 + %.2f = %.2f us\n", eRead,
+         eGemmF, eRead + eGemmF);
+  printf("mmap view + GEMM (float): %.2f us\n", eMapped);
+  printf("read dataset + GEMM (float): %.2f + %.2f = %.2f us\n", eDataset,
+         eGemmDs, eDataset + eGemmDs);
+  printf("max |double - float| score: %g\n\n", err);
+}
+
 // int main() {
 //   unsigned n = 1e4;
 //   VectorXd x(n);
@@ -165,7 +224,11 @@ std::vector<T> flatVecMutiply(const std::vector<T> &M,
 //          "%.6f, %.6f, %.6f, %.6f\n\n",
 //          e2, e0, e1, e3, sum2, sum0, sum1, sum3);
 // }
-int main() {
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    fprintf(stderr, "Usage: %s [fvecs filename]\n\n", argv[0]);
+    return EXIT_FAILURE;
+  }
   unsigned m = 1e3;
   unsigned n = 400;
   auto flatM = genUniformData<float>(2, m, n);
@@ -186,46 +249,60 @@ int main() {
   printf("Start benchmarking ...\n");
   printf("size(M) = [%ld, %ld], size(x) = %lu\n", mat.rows(), mat.cols(),
          x.size());
+  // each product is timed here and in its own profiler zone, so the zones
+  // can be compared against the plain timer; the TSC is calibrated first
+  RdtscTimer::usesTsc();
   HighResolutionTimer timer;
   timer.restart();
-  auto y1 = eigenMutiply(mat, eigenV);
+  auto y1 = [&] {
+    PROFILE_ZONE("eigenMutiply");
+    return eigenMutiply(mat, eigenV);
+  }();
   auto e1 = timer.elapsed();
 
   timer.restart();
-  auto y2 = eigenManualMutiply(mat, eigenV);
+  auto y2 = [&] {
+    PROFILE_ZONE("eigenManualMutiply");
+    return eigenManualMutiply(mat, eigenV);
+  }();
   auto e2 = timer.elapsed();
 
   timer.restart();
-  auto y3 = twoDimVecMutiply(twoDimVec, x);
+  auto y3 = [&] {
+    PROFILE_ZONE("twoDimVecMutiply");
+    return twoDimVecMutiply(twoDimVec, x);
+  }();
   auto e3 = timer.elapsed();
 
   timer.restart();
-  auto y4 = flatVecMutiply(flatM, x);
+  auto y4 = [&] {
+    PROFILE_ZONE("flatVecMutiply");
+    return flatVecMutiply(flatM, x);
+  }();
   auto e4 = timer.elapsed();
 
   printf("eigenMutiply: %.2f\neigenManualMutiply: %.2f\ntwoDimVecMutiply: "
          "%.2f\nflatVecMutiply: %.2f\n\n",
          e1, e2, e3, e4);
+#ifndef DISABLE_PROFILE
+  printf("%s\n", Profiler::text().c_str());
+#endif
 
-  FILE *fp = fopen("1.txt", "w");
-  for (unsigned i = 0; i < y1.size(); ++i)
-    fprintf(fp, "%.6f\n", y1[i]);
-  fclose(fp);
-
-  fp = fopen("2.txt", "w");
-  for (unsigned i = 0; i < y2.size(); ++i)
-    fprintf(fp, "%.6f\n", y2[i]);
-  fclose(fp);
-
-  fp = fopen("3.txt", "w");
-  for (unsigned i = 0; i < y3.size(); ++i)
-    fprintf(fp, "%.6f\n", y3[i]);
-  fclose(fp);
-
-  fp = fopen("4.txt", "w");
-  for (unsigned i = 0; i < y4.size(); ++i)
-    fprintf(fp, "%.6f\n", y4[i]);
-  fclose(fp);
+  // one buffer for all dumps, each written with a single fwrite
+  CharBuffer text;
+  auto dump = [&text](const char *filename, const auto &y) {
+    for (unsigned i = 0; i < y.size(); ++i)
+      text.appendFixed(y[i], 6).append('\n');
+    FILE *fp = fopen(filename, "w");
+    text.writeTo(fp);
+    fclose(fp);
+  };
+  dump("1.txt", y1);
+  dump("2.txt", y2);
+  dump("3.txt", y3);
+  dump("4.txt", y4);
+
+  benchRealData(argc == 2 ? argv[1] : "./sample-data/gist_query.fvecs", 100);
 
   return 0;
 }
\ No newline at end of file
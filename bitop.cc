@@ -1,3 +1,4 @@
+#include "NumberFormat.hpp"
 #include "Timer.hpp"
 #include <bitset>
 #include <cstdint>
@@ -104,13 +105,14 @@ int main() {
 
   printf("bitset: %.2f\nraw: %.2f\n", e1, e2);
 
-  FILE *fp = fopen("1.txt", "w");
-  for (unsigned i = 0; i < y1.size(); ++i)
-    fprintf(fp, "%lu\n", y1[i]);
-  fclose(fp);
-
-  fp = fopen("2.txt", "w");
-  for (unsigned i = 0; i < y2.size(); ++i)
-    fprintf(fp, "%lu\n", y2[i]);
-  fclose(fp);
+  CharBuffer text;
+  auto dump = [&text](const char *filename, const std::vector<uint64_t> &y) {
+    for (unsigned i = 0; i < y.size(); ++i)
+      text.appendInt(y[i]).append('\n');
+    FILE *fp = fopen(filename, "w");
+    text.writeTo(fp);
+    fclose(fp);
+  };
+  dump("1.txt", y1);
+  dump("2.txt", y2);
 }
\ No newline at end of file
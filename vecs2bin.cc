@@ -0,0 +1,38 @@
+#include "BinVecs.hpp"
+#include "Timer.hpp"
+
+int main(int argc, char **argv) {
+  if (!(argc == 2 || argc == 3)) {
+    fprintf(stderr,
+            "Usage: %s <fvecs/bvecs/ivecs filename> [output filename]\n\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::string input = argv[1];
+  std::string output = (argc == 3) ? argv[2] : BinVecs::cacheName(input);
+
+  HighResolutionTimer timer;
+  timer.restart();
+  auto n = BinVecs::convert(input, output);
+  auto e1 = timer.elapsed();
+  printf("converted %lu points from %s to %s in %.2f us\n", n, input.c_str(),
+         output.c_str(), e1);
+
+  // time a cold open of the cache and a checksum pass; the input reader is
+  // only needed for the element type and is not timed
+  auto dim = visitVecsReader<float>(input, [&](auto &reader) {
+    using Elem = typename std::decay_t<decltype(reader)>::ElemType;
+    timer.restart();
+    BinVecsReader<Elem> cache(output.c_str());
+    auto view = cache.view();
+    auto e2 = timer.elapsed();
+    timer.restart();
+    bool ok = cache.verify();
+    auto e3 = timer.elapsed();
+    printf("open: %.2f us, verify (%s): %.2f us\n", e2, ok ? "ok" : "FAILED",
+           e3);
+    return view.pointDimension();
+  });
+  printf("# of dim: %u\n", dim);
+  return EXIT_SUCCESS;
+}
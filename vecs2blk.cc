@@ -0,0 +1,68 @@
+#include <algorithm>
+#include "BlockVecs.hpp"
+#include "Timer.hpp"
+
+// write back and drop the cached pages of <filename>, so that the next scan
+// reads it from the disk
+void dropCache(const std::string &filename) {
+  PosixFile file(filename);
+  ::fdatasync(file.fd());
+  ::posix_fadvise(file.fd(), 0, 0, POSIX_FADV_DONTNEED);
+}
+
+int main(int argc, char **argv) {
+  if (!(argc >= 2 && argc <= 4)) {
+    fprintf(stderr,
+            "Usage: %s <fvecs/bvecs/ivecs filename> [output filename] "
+            "[points per block, 0 to pick it]\n\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::string input = argv[1];
+  std::string output = (argc >= 3) ? argv[2] : BlockVecs::blockName(input);
+  uint32_t blockPoints = (argc == 4) ? std::stoul(argv[3]) : 0; // 0: auto
+
+  HighResolutionTimer timer;
+  timer.restart();
+  auto n = BlockVecs::compress(input, output, blockPoints);
+  auto e1 = timer.elapsed();
+  printf("compressed %lu points from %s to %s in %.2f us\n", n, input.c_str(),
+         output.c_str(), e1);
+
+  // time full scans of the original and of the compressed file into reused
+  // buffers, the best of a few runs, from the page cache and from the disk
+  visitVecsReader<float>(input, [&](auto &reader) {
+    using Elem = typename std::decay_t<decltype(reader)>::ElemType;
+    BlockVecsReader<Elem> blk(output.c_str());
+    printf("ratio: %.3f (%lu / %lu bytes), %lu blocks of %lu points\n",
+           static_cast<double>(blk.compressedSize()) / blk.rawSize(),
+           blk.compressedSize(), blk.rawSize(), blk.numBlocks(),
+           blk.blockPoints());
+    const double mb = blk.rawSize() / 1e6;
+    const size_t n = blk.numPoints();
+    std::vector<Elem> raw(blk.rawSize() / sizeof(Elem)), unpacked(raw.size());
+    for (bool cold : {false, true}) {
+      double e2 = 0, e3 = 0;
+      for (int run = 0; run < 5; ++run) {
+        if (cold)
+          dropCache(input);
+        timer.restart();
+        reader.readInto(Span<Elem>(raw), 0, n);
+        double e = timer.elapsed();
+        e2 = run == 0 ? e : std::min(e2, e);
+        if (cold)
+          dropCache(output);
+        timer.restart();
+        blk.readInto(Span<Elem>(unpacked), 0, n);
+        e = timer.elapsed();
+        e3 = run == 0 ? e : std::min(e3, e);
+      }
+      printf("%s scan: raw %.2f us (%.0f MB/s), compressed %.2f us "
+             "(%.0f MB/s) (%s)\n",
+             cold ? "cold" : "warm", e2, mb / e2 * 1e6, e3, mb / e3 * 1e6,
+             raw == unpacked ? "ok" : "MISMATCH");
+    }
+    return 0;
+  });
+  return EXIT_SUCCESS;
+}